@@ -0,0 +1,123 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+// CPU cost of the splice and the buffered mod receive paths, fed by a stand-in server on loopback.
+// Only the receiving thread is measured, hashing included, like in a real download.
+// usage: RecvBench [size in MB, default 1024]
+#include "Network/network.hpp"
+#include "Security/Sha256.h"
+#include "linuxfixes.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <functional>
+#include <netinet/in.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// defined in src/Network/Resources.cpp
+int64_t SpliceRcv(SOCKET Sock, int Fd, uint64_t Offset, uint64_t Size, uint64_t& GRcv, Sha256& Hash);
+bool BufferedRcv(SOCKET Sock, const std::string& Path, uint64_t Offset, uint64_t Size, uint64_t& GRcv, Sha256& Hash);
+
+static double CpuSeconds() {
+    rusage Usage {};
+    getrusage(RUSAGE_THREAD, &Usage);
+    return double(Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec) + double(Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec) / 1e6;
+}
+
+// accepts one connection and sends Size bytes of junk down it
+static void Serve(int Listener, uint64_t Size) {
+    int Sock = accept(Listener, nullptr, nullptr);
+    std::vector<char> Block(1 << 20, 'B');
+    for (uint64_t Sent = 0; Sent < Size;) {
+        ssize_t Len = send(Sock, Block.data(), std::min<uint64_t>(Block.size(), Size - Sent), MSG_NOSIGNAL);
+        if (Len < 1)
+            break;
+        Sent += Len;
+    }
+    close(Sock);
+}
+
+struct Result {
+    double Wall = 0;
+    double Cpu = 0;
+    bool Ok = false;
+};
+
+static Result Run(uint64_t Size, const std::function<bool(SOCKET, uint64_t&, Sha256&)>& Receive) {
+    int Listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in Addr {};
+    Addr.sin_family = AF_INET;
+    Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t AddrLen = sizeof(Addr);
+    bind(Listener, reinterpret_cast<sockaddr*>(&Addr), sizeof(Addr));
+    listen(Listener, 1);
+    getsockname(Listener, reinterpret_cast<sockaddr*>(&Addr), &AddrLen);
+    std::thread Server(Serve, Listener, Size);
+
+    int Sock = socket(AF_INET, SOCK_STREAM, 0);
+    Result R;
+    if (connect(Sock, reinterpret_cast<sockaddr*>(&Addr), sizeof(Addr)) == 0) {
+        uint64_t GRcv = 0;
+        Sha256 Hash;
+        double Cpu = CpuSeconds();
+        auto Start = std::chrono::steady_clock::now();
+        R.Ok = Receive(SOCKET(Sock), GRcv, Hash) && GRcv == Size;
+        Hash.Final();
+        R.Wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        R.Cpu = CpuSeconds() - Cpu;
+    }
+    close(Sock);
+    Server.join();
+    close(Listener);
+    return R;
+}
+
+static void Report(const char* Name, uint64_t Size, const Result& R) {
+    double GB = double(Size) / (1024.0 * 1024 * 1024);
+    if (!R.Ok) {
+        std::printf("%-9s failed\n", Name);
+        return;
+    }
+    std::printf("%-9s %8.1f MB/s  %8.3f CPU s/GB\n", Name, GB * 1024 / R.Wall, R.Cpu / GB);
+}
+
+int main(int argc, char** argv) {
+    uint64_t Size = (argc > 1 ? std::stoull(argv[1]) : 1024) * 1024 * 1024;
+    std::string Path = (fs::temp_directory_path() / "beammp-recv-bench.bin").string();
+
+    auto Prepare = [&] {
+        fs::remove(Path);
+        int Fd = open(Path.c_str(), O_RDWR | O_CREAT, 0644);
+        ftruncate(Fd, off_t(Size));
+        return Fd;
+    };
+
+    int Fd = Prepare();
+    Result Splice = Run(Size, [&](SOCKET Sock, uint64_t& GRcv, Sha256& Hash) {
+        return SpliceRcv(Sock, Fd, 0, Size, GRcv, Hash) == int64_t(Size);
+    });
+    close(Fd);
+
+    close(Prepare());
+    Result Buffered = Run(Size, [&](SOCKET Sock, uint64_t& GRcv, Sha256& Hash) {
+        return BufferedRcv(Sock, Path, 0, Size, GRcv, Hash);
+    });
+    fs::remove(Path);
+
+    std::printf("received  %llu MB\n", static_cast<unsigned long long>(Size / (1024 * 1024)));
+    Report("splice", Size, Splice);
+    Report("buffered", Size, Buffered);
+    return Splice.Ok && Buffered.Ok ? 0 : 1;
+}
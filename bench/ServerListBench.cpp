@@ -0,0 +1,93 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+// One server browser refresh through the /servers page query against the full servers-info dump,
+// where every refresh parses, filters and sorts the whole list like the game's Lua browser does.
+// usage: ServerListBench [servers, default 5000]
+#include "Network/ServerIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string MakeList(size_t Count) {
+    const char* Maps[] = { "/levels/west_coast_usa/info.json", "/levels/utah/info.json", "/levels/italy/info.json",
+        "/levels/gridmap_v2/info.json", "/levels/east_coast_usa/info.json" };
+    std::mt19937 Rng(42);
+    nlohmann::json List = nlohmann::json::array();
+    for (size_t i = 0; i < Count; i++) {
+        unsigned Max = 8 + Rng() % 40;
+        List.push_back({
+            { "sname", "^l^6Server " + std::to_string(i) + " ^r| freeroam ^4racing" },
+            { "sdesc", "A description of server " + std::to_string(i) + " with rules, links and a few color codes ^a^l" },
+            { "map", Maps[Rng() % 5] },
+            { "location", i % 3 ? "DE" : "US" },
+            { "version", "3.4.1" },
+            { "players", std::to_string(Rng() % (Max + 1)) },
+            { "maxplayers", std::to_string(Max) },
+            { "official", i % 50 == 0 ? "true" : "false" },
+            { "password", i % 7 == 0 ? "true" : "false" },
+            { "ip", "10.0." + std::to_string(i / 256 % 256) + "." + std::to_string(i % 256) },
+            { "port", std::to_string(30814 + i % 100) },
+            { "modlist", "/mods/a.zip;/mods/b.zip;/mods/c.zip;" },
+        });
+    }
+    return List.dump();
+}
+
+// the search the browser sends most: not full, busiest first, first page
+static ServerIndex::Query PageQuery() {
+    ServerIndex::Query Q;
+    Q.Text = "racing";
+    Q.HideFull = true;
+    return Q;
+}
+
+// what the game does with the full dump on every refresh
+static size_t FullDump(const std::string& List) {
+    auto d = nlohmann::json::parse(List);
+    std::vector<const nlohmann::json*> Matches;
+    for (const auto& S : d) {
+        if (std::stoul(S["players"].get<std::string>()) >= std::stoul(S["maxplayers"].get<std::string>()))
+            continue;
+        if (S["sname"].get<std::string>().find("racing") == std::string::npos)
+            continue;
+        Matches.push_back(&S);
+    }
+    std::stable_sort(Matches.begin(), Matches.end(), [](const nlohmann::json* a, const nlohmann::json* b) {
+        return std::stoul((*a)["players"].get<std::string>()) > std::stoul((*b)["players"].get<std::string>());
+    });
+    return Matches.size();
+}
+
+// average milliseconds of Runs calls
+static double Time(int Runs, const std::function<void()>& Call) {
+    auto Start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Runs; i++)
+        Call();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / Runs;
+}
+
+int main(int argc, char** argv) {
+    size_t Count = argc > 1 ? std::stoul(argv[1]) : 5000;
+    std::string List = MakeList(Count);
+    ServerIndex Index;
+    std::string Page;
+
+    double Build = Time(5, [&] { Index.Update(List, 0); });
+    double Query = Time(200, [&] { Page = Index.Find(PageQuery()); });
+    size_t Matches = 0;
+    double Dump = Time(5, [&] { Matches = FullDump(List); });
+
+    std::printf("servers      %zu, %zu KB list, %zu matches\n", Count, List.size() / 1024, Matches);
+    std::printf("full dump    %8.3f ms per refresh, %zu KB sent\n", Dump, List.size() / 1024);
+    std::printf("index build  %8.3f ms once per new list\n", Build);
+    std::printf("page query   %8.3f ms per refresh, %zu KB sent\n", Query, Page.size() / 1024);
+    return 0;
+}
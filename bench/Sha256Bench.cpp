@@ -0,0 +1,64 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+// Sha256::File against the hashpp file hash it replaced, on a generated file.
+// usage: Sha256Bench [size in MB, default 512]
+#include "Security/Sha256.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+// hashpp.h relies on <cstring> being included before it
+#include "hashpp.h"
+
+namespace fs = std::filesystem;
+
+// best of three runs, the first one also warms the page cache
+static double Throughput(uint64_t Bytes, const std::function<std::string()>& Hash, std::string& Result) {
+    double Best = 0;
+    for (int i = 0; i < 3; i++) {
+        auto Start = std::chrono::steady_clock::now();
+        Result = Hash();
+        std::chrono::duration<double> Took = std::chrono::steady_clock::now() - Start;
+        Best = std::max(Best, double(Bytes) / (1024 * 1024) / Took.count());
+    }
+    return Best;
+}
+
+int main(int argc, char** argv) {
+    uint64_t Size = (argc > 1 ? std::stoull(argv[1]) : 512) * 1024 * 1024;
+    std::string Path = (fs::temp_directory_path() / "beammp-sha256-bench.bin").string();
+    {
+        std::mt19937_64 Rng(42);
+        std::vector<uint64_t> Block(1 << 17);
+        std::ofstream File(Path, std::ios::binary);
+        for (uint64_t Written = 0; Written < Size; Written += Block.size() * 8) {
+            std::generate(Block.begin(), Block.end(), std::ref(Rng));
+            File.write(reinterpret_cast<const char*>(Block.data()), std::streamsize(std::min<uint64_t>(Block.size() * 8, Size - Written)));
+        }
+    }
+
+    std::string OpenSSL, HashPP;
+    double OpenSSLRate = Throughput(Size, [&] { return Sha256::File(Path); }, OpenSSL);
+    double HashPPRate = Throughput(Size, [&] { return hashpp::get::getFileHash(hashpp::ALGORITHMS::SHA2_256, Path).getString(); }, HashPP);
+    fs::remove(Path);
+
+    std::printf("file      %llu MB\n", static_cast<unsigned long long>(Size / (1024 * 1024)));
+    std::printf("Sha256    %8.1f MB/s\n", OpenSSLRate);
+    std::printf("hashpp    %8.1f MB/s\n", HashPPRate);
+    std::printf("speedup   %8.2fx\n", OpenSSLRate / HashPPRate);
+    if (OpenSSL != HashPP) {
+        std::cerr << "digests differ: " << OpenSSL << " vs " << HashPP << std::endl;
+        return 1;
+    }
+    return 0;
+}
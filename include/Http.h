@@ -7,14 +7,21 @@
 ///
 #pragma once
 #include "Logger.h"
+#include <future>
 #include <string>
 class HTTP {
 public:
     static bool Download(const std::string& IP, const std::string& Path);
     static std::string Post(const std::string& IP, const std::string& Fields);
     static std::string Get(const std::string& IP);
+    /// Get through the backend response cache that the local proxy uses as well
+    static std::string CachedGet(const std::string& IP);
+    static std::future<std::string> PostAsync(const std::string& IP, const std::string& Fields);
+    static std::future<std::string> GetAsync(const std::string& IP);
     static bool ProgressBar(size_t c, size_t t);
     static void StartProxy();
-public:
-    static bool isDownload;
+    static void SetMaxConnections(size_t Max);
+    static void SetDownloadParts(size_t Parts);
+    static void SetProxyThreads(size_t Threads);
+    static void SetProxyStreaming(bool Enabled);
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Keeps the Resources folder under a size budget by evicting the least recently used mods.
+/// Mods of the server we are syncing with are pinned and never evicted.
+class ModCache {
+public:
+    static void SetBudget(uint64_t Bytes);
+    static void StartCollector();
+    static void BeginSession(const std::vector<std::string>& Names);
+    /// Digest is the stripe hash from MultiDownload, the sha256 of both half digests and not the sha256 of the file.
+    /// Empty keeps the one already indexed
+    static void Use(const std::string& Name, const std::string& Digest = "");
+    static void EndSession();
+};
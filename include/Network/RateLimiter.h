@@ -0,0 +1,32 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+/// Token bucket shared by every download socket, Rate is in bytes per second and 0 means unlimited
+class RateLimiter {
+public:
+    void SetRate(uint64_t BytesPerSec);
+    uint64_t GetRate();
+    /// blocks until up to Wanted bytes may be received and returns how many
+    uint64_t Acquire(uint64_t Wanted);
+    /// gives back tokens that were acquired but not used
+    void Refund(uint64_t Bytes);
+    void Record(uint64_t Bytes);
+    void StartMeasure();
+    uint64_t AchievedRate();
+
+private:
+    std::mutex Lock;
+    uint64_t Rate = 0;
+    double Tokens = 0;
+    std::chrono::steady_clock::time_point LastRefill = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point MeasureStart = std::chrono::steady_clock::now();
+    uint64_t Measured = 0;
+};
+
+extern RateLimiter DownloadLimiter;
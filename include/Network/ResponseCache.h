@@ -0,0 +1,69 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <httplib.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+
+/// In memory cache for upstream GET responses that honors Cache-Control and revalidates with If-None-Match
+class ResponseCache {
+public:
+    struct Entry {
+        int Status = 0;
+        /// shared so handing out an entry never copies the body, bodies are never modified once stored
+        std::shared_ptr<const std::string> Body = std::make_shared<const std::string>();
+        std::string ContentType;
+        /// Body is kept as it came over the wire, in this Content-Encoding
+        std::string Encoding;
+        std::string ETag;
+        std::string Error;
+        /// changes whenever a new body arrives, revalidation keeps it, so derived data can be rebuilt only when needed
+        uint64_t Generation = 0;
+        std::chrono::steady_clock::time_point Expires;
+    };
+    /// performs the upstream request with the extra (conditional) headers added
+    using Fetcher = std::function<httplib::Result(const httplib::Headers&)>;
+    /// the claim of the one request that fetches a key that missed, the others wait for its Complete
+    struct Ticket {
+        std::string Key;
+        /// conditional headers the upstream request has to send
+        httplib::Headers Extra;
+        Entry Cached;
+        bool Found = false;
+        std::chrono::seconds Lifetime { 0 };
+        std::chrono::steady_clock::time_point Now;
+        std::promise<Entry> Promise;
+    };
+
+    Entry Get(const std::string& Key, const Fetcher& Fetch);
+    /// the lookup half of Get for callers that fetch on their own, e.g. to pass the body on while it arrives.
+    /// Returns the entry on a hit or once a concurrent fetch is done, otherwise the caller has to fetch and Complete
+    std::optional<Entry> Begin(const std::string& Key, Ticket& T);
+    /// stores the upstream response of a Ticket, Res->body has to hold the whole body, and wakes up waiting requests
+    Entry Complete(Ticket& T, httplib::Result& Res);
+    void SetTTL(std::chrono::seconds NewTTL);
+    bool Enabled();
+    nlohmann::json Stats();
+
+private:
+    /// turns the upstream response into the entry the ticket holder and its waiters get
+    Entry Store(Ticket& T, httplib::Result& Res);
+
+    std::mutex Lock;
+    std::map<std::string, Entry> Entries;
+    std::map<std::string, std::shared_future<Entry>> InFlight;
+    std::chrono::seconds TTL { 30 };
+    std::atomic<uint64_t> Hits = 0, Misses = 0, Generations = 0, Revalidated = 0, Stale = 0, Coalesced = 0;
+};
+
+extern ResponseCache BackendCache;
@@ -0,0 +1,62 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// The backend server list parsed once into flat records with presorted orders, so the browser can ask for one page
+class ServerIndex {
+public:
+    struct Query {
+        /// case insensitive, matched against name, map, description and location
+        std::string Text;
+        std::string Map;
+        std::string Version;
+        /// players, name or map
+        std::string Sort = "players";
+        bool Descending = true;
+        bool OfficialOnly = false;
+        bool HideFull = false;
+        bool HideEmpty = false;
+        bool HidePassword = false;
+        size_t Offset = 0;
+        size_t Limit = 50;
+    };
+
+    /// true if the index was built from the cache entry of this generation
+    bool IsCurrent(uint64_t Generation);
+    /// rebuilds the index from Json, the decoded body of the cache entry of that generation
+    void Update(const std::string& Json, uint64_t Generation);
+    /// {"total":<matches>,"offset":<n>,"servers":[...]} with the original server objects of the requested page
+    std::string Find(const Query& Q);
+
+private:
+    struct Server {
+        /// the server object as the backend sent it, copied into responses as is
+        std::string Raw;
+        /// lower case name, map, description and location without ^ color codes
+        std::string Search;
+        std::string Name;
+        std::string Map;
+        std::string Version;
+        uint32_t Players = 0;
+        uint32_t MaxPlayers = 0;
+        bool Official = false;
+        bool Password = false;
+    };
+    struct Snapshot {
+        uint64_t Generation = 0;
+        std::vector<Server> Servers;
+        std::vector<uint32_t> ByPlayers, ByName, ByMap;
+    };
+
+    std::mutex Lock;
+    std::shared_ptr<const Snapshot> Current = std::make_shared<Snapshot>();
+};
+
+extern ServerIndex ServerList;
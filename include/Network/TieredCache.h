@@ -0,0 +1,41 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/// Memory LRU in front of a disk directory. Concurrent lookups of the same key share one load
+class TieredCache {
+public:
+    struct Blob {
+        std::string Data;
+        std::string Type;
+    };
+    using Loader = std::function<std::optional<Blob>()>;
+
+    TieredCache(std::filesystem::path Dir, size_t Capacity, std::chrono::seconds DiskTTL);
+    std::optional<Blob> Get(const std::string& Key, const Loader& Load);
+
+private:
+    std::optional<Blob> ReadDisk(const std::string& Key);
+    void WriteDisk(const std::string& Key, const Blob& Value);
+    void Remember(const std::string& Key, const Blob& Value);
+
+    std::filesystem::path Dir;
+    size_t Capacity;
+    std::chrono::seconds DiskTTL;
+    std::mutex Lock;
+    std::list<std::pair<std::string, Blob>> Recent;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Blob>>::iterator> Index;
+    std::map<std::string, std::shared_future<std::optional<Blob>>> InFlight;
+};
@@ -0,0 +1,34 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern bool ModCRCCheck;
+
+/// reads the central directory of the archive and, if CheckCRC is set, inflates every entry to compare CRCs
+bool VerifyZip(const std::string& Path, bool CheckCRC);
+
+/// runs VerifyZip on a small pool of worker threads so verification overlaps with downloading
+class ZipVerifier {
+public:
+    explicit ZipVerifier(size_t Workers);
+    ~ZipVerifier();
+    std::future<bool> Submit(const std::string& Path);
+    size_t WorkerCount() const { return Threads.size(); }
+
+private:
+    void Worker();
+    std::mutex Lock;
+    std::condition_variable Cv;
+    std::deque<std::packaged_task<bool()>> Jobs;
+    std::vector<std::thread> Threads;
+    bool Stop = false;
+};
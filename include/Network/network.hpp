@@ -21,6 +21,10 @@ extern bool Dev;
 extern int ping;
 
 [[noreturn]] void CoreNetwork();
+/// the core and proxy listeners are up from the start, they hold requests back until this is called
+void SetLauncherReady();
+bool LauncherReady();
+void WaitLauncherReady();
 extern int ProxyPort;
 extern int ClientID;
 extern int LastPort;
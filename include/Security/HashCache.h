@@ -0,0 +1,16 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <functional>
+#include <string>
+
+/// Remembers file hashes across starts, keyed by path, size, modification time and file id.
+/// A file is only hashed again once any of those change, or always when full verification is forced.
+class HashCache {
+public:
+    using Hasher = std::function<std::string(const std::string& Path)>;
+    static std::string Get(const std::string& Path, const Hasher& Hash);
+    static void SetForceVerify(bool Force);
+};
@@ -7,8 +7,13 @@
 ///
 #pragma once
 #include <string>
+/// cleans mods/multiplayer and enables the mod in db.json, has to be done before the game starts
 void PreGame(const std::string& GamePath);
+/// checks BeamMP.zip against the backend and downloads the update
+void UpdateMP();
 std::string CheckVer(const std::string& path);
+/// CheckVer, remembered until integrity.json changes
+std::string GameVersion(const std::string& dir);
 void InitGame(const std::string& Dir);
 std::string GetGameDir();
 void LegitimacyCheck();
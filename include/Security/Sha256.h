@@ -0,0 +1,29 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+/// incremental SHA-256 backed by OpenSSL
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+    Sha256();
+    ~Sha256();
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+    void Update(const void* Data, size_t Len);
+    Digest Final();
+    static std::string Hex(const Digest& D);
+    /// lower case hex digest of a whole file, empty if it can not be read
+    static std::string File(const std::string& Path);
+
+private:
+    EVP_MD_CTX* Ctx;
+};
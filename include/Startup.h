@@ -10,7 +10,12 @@
 #include <string>
 #include <vector>
 
+/// console, log and name checks that have to happen before any other startup step
 void InitLauncher(int argc, char* argv[]);
+void CustomPort(int argc, char* argv[]);
+/// true if a launcher update was downloaded and the launcher has to URelaunch
+bool CheckForUpdates(const std::string& CV);
+void URelaunch(int argc, char* args[]);
 std::string GetEP(char* P = nullptr);
 std::string GetGamePath();
 std::string GetVer();
@@ -18,4 +23,5 @@ std::string GetPatch();
 std::string GetEN();
 void ConfigInit();
 extern bool Dev;
+extern bool EarlyGameStart;
 
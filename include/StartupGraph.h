@@ -0,0 +1,35 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+/// Runs startup steps on their own threads as soon as the steps they depend on are done.
+/// A step that throws keeps everything after it from running and Run rethrows once all other steps finished
+class StartupGraph {
+public:
+    /// every name in After has to be added before
+    void Add(const std::string& Name, const std::vector<std::string>& After, std::function<void()> Step);
+    void Run();
+
+private:
+    struct Task {
+        std::string Name;
+        std::vector<std::string> After;
+        std::shared_future<void> Done;
+        std::chrono::steady_clock::duration Start {}, End {};
+    };
+    void LogCriticalPath();
+
+    std::chrono::steady_clock::time_point Begin = std::chrono::steady_clock::now();
+    // a deque so running steps keep their Task while later ones are added
+    std::deque<Task> Tasks;
+    std::map<std::string, size_t> Index;
+};
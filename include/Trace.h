@@ -0,0 +1,29 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+#pragma once
+#include <chrono>
+#include <string>
+
+/// Times the enclosing scope and records it as one event of the launcher trace
+class TraceSpan {
+public:
+    explicit TraceSpan(std::string Name, std::string Category = "startup", std::string Detail = "");
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    std::string Name, Category, Detail;
+    std::chrono::steady_clock::time_point Start;
+};
+
+/// Recorded spans in the Chrome trace event format, open with chrome://tracing or ui.perfetto.dev
+class Trace {
+public:
+    static std::string Json();
+    /// file Save writes to, empty (the default) means the trace is only served by the proxy
+    static void SetFile(const std::string& Path);
+    static void Save();
+};
@@ -11,3 +11,4 @@
 
 std::vector<char> Comp(std::span<const char> input);
 std::vector<char> DeComp(std::span<const char> input);
+std::vector<char> HttpDeComp(std::span<const char> input);
@@ -60,3 +60,39 @@ std::vector<char> DeComp(std::span<const char> input) {
     }    output_buffer.resize(output_size);
     return output_buffer;
 }
+
+static std::vector<char> Inflate(std::span<const char> input, int windowBits) {
+    z_stream strm {};
+    if (inflateInit2(&strm, windowBits) != Z_OK) {
+        throw std::runtime_error("zlib inflateInit2() failed");
+    }
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    strm.avail_in = static_cast<uInt>(input.size());
+    std::vector<char> output;
+    int res;
+    do {
+        size_t done = output.size();
+        output.resize(done + 64 * 1024);
+        strm.next_out = reinterpret_cast<Bytef*>(output.data() + done);
+        strm.avail_out = 64 * 1024;
+        res = inflate(&strm, Z_NO_FLUSH);
+        output.resize(output.size() - strm.avail_out);
+        if ((res != Z_OK && res != Z_STREAM_END) || (res == Z_OK && strm.avail_in == 0 && strm.avail_out != 0)) {
+            inflateEnd(&strm);
+            throw std::runtime_error("zlib inflate() failed: " + std::to_string(res));
+        }
+    } while (res != Z_STREAM_END);
+    inflateEnd(&strm);
+    return output;
+}
+
+// inflates an HTTP body with Content-Encoding gzip or deflate
+std::vector<char> HttpDeComp(std::span<const char> input) {
+    try {
+        // 32 lets zlib detect the gzip or zlib header on its own
+        return Inflate(input, 32 + MAX_WBITS);
+    } catch (const std::runtime_error&) {
+        // many servers send deflate as a raw stream without the zlib header
+        return Inflate(input, -MAX_WBITS);
+    }
+}
@@ -2,8 +2,16 @@
 /// Created by Anonymous275 on 2/23/2021
 ///
 
+#include "Http.h"
 #include "Logger.h"
 #include "Network/network.hpp"
+#include "Network/ModCache.h"
+#include "Network/ResponseCache.h"
+#include "Network/RateLimiter.h"
+#include "Network/ZipVerifier.h"
+#include "Security/HashCache.h"
+#include "Startup.h"
+#include "Trace.h"
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
@@ -26,9 +34,54 @@ void ParseConfig(const nlohmann::json& d) {
         for (char& c : Branch)
             c = char(tolower(c));
     }
+    // KB/s, 0 or missing means unlimited
+    if (d.contains("DownloadLimit") && d["DownloadLimit"].is_number_unsigned()) {
+        DownloadLimiter.SetRate(d["DownloadLimit"].get<uint64_t>() * 1024);
+    }
+    // synced mods always get their central directory checked, this also inflates them to check CRCs
+    if (d.contains("VerifyModCRC") && d["VerifyModCRC"].is_boolean()) {
+        ModCRCCheck = d["VerifyModCRC"].get<bool>();
+    }
+    // MB, least recently used mods in Resources are deleted once it grows past this
+    if (d.contains("CacheSizeLimit") && d["CacheSizeLimit"].is_number_unsigned()) {
+        ModCache::SetBudget(d["CacheSizeLimit"].get<uint64_t>() * 1024 * 1024);
+    }
+    // concurrent keep-alive connections per backend host
+    if (d.contains("HttpConnections") && d["HttpConnections"].is_number_unsigned()) {
+        HTTP::SetMaxConnections(d["HttpConnections"].get<size_t>());
+    }
+    // byte ranges fetched at once for large launcher and client mod downloads, 1 disables it
+    if (d.contains("DownloadParts") && d["DownloadParts"].is_number_unsigned()) {
+        HTTP::SetDownloadParts(d["DownloadParts"].get<size_t>());
+    }
+    // worker threads of the local HTTP proxy
+    if (d.contains("ProxyThreads") && d["ProxyThreads"].is_number_unsigned()) {
+        HTTP::SetProxyThreads(d["ProxyThreads"].get<size_t>());
+    }
+    // seconds the proxy may serve backend responses from memory, 0 disables the cache
+    if (d.contains("ProxyCacheTTL") && d["ProxyCacheTTL"].is_number_unsigned()) {
+        BackendCache.SetTTL(std::chrono::seconds(d["ProxyCacheTTL"].get<int64_t>()));
+    }
+    // hash the launcher and BeamMP.zip on every start instead of trusting unchanged file metadata
+    if (d.contains("VerifyHashes") && d["VerifyHashes"].is_boolean()) {
+        HashCache::SetForceVerify(d["VerifyHashes"].get<bool>());
+    }
+    // start the game while the BeamMP mod is checked and updated, it can only reach the core once that is done
+    if (d.contains("EarlyGameStart") && d["EarlyGameStart"].is_boolean()) {
+        EarlyGameStart = d["EarlyGameStart"].get<bool>();
+    }
+    // record where startup time goes and write it to startup_trace.json next to the launcher
+    if (d.contains("StartupTrace") && d["StartupTrace"].is_boolean() && d["StartupTrace"].get<bool>()) {
+        Trace::SetFile(GetEP() + "startup_trace.json");
+    }
+    // forward backend responses chunk by chunk instead of buffering them first, cache misses are stored once complete
+    if (d.contains("ProxyStreaming") && d["ProxyStreaming"].is_boolean()) {
+        HTTP::SetProxyStreaming(d["ProxyStreaming"].get<bool>());
+    }
 }
 
 void ConfigInit() {
+    TraceSpan Span("ConfigInit");
     if (fs::exists("Launcher.cfg")) {
         std::ifstream cfg("Launcher.cfg");
         if (cfg.is_open()) {
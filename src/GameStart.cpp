@@ -19,8 +19,10 @@
 
 #include "Logger.h"
 #include "Startup.h"
+#include "Trace.h"
 #include <Security/Init.h>
 #include <filesystem>
+#include <mutex>
 #include <thread>
 
 unsigned long GamePID = 0;
@@ -48,7 +50,7 @@ std::string GetGamePath() {
         Path = QueryKey(hKey, 5);
         Path += "\\BeamNG.drive\\";
     }
-    std::string Ver = CheckVer(GetGameDir());
+    std::string Ver = GameVersion(GetGameDir());
     Ver = Ver.substr(0, Ver.find('.', Ver.find('.') + 1));
     Path += Ver + "\\";
     info("Game user path: '" + Path + "'");
@@ -56,15 +58,20 @@ std::string GetGamePath() {
 }
 #elif defined(__linux__)
 std::string GetGamePath() {
-    // Right now only steam is supported
-    struct passwd* pw = getpwuid(getuid());
-    std::string homeDir = pw->pw_dir;
+    // the mod sync asks for this several times per mod, so it is worked out once
+    static std::string Path;
+    static std::once_flag Once;
+    std::call_once(Once, [] {
+        // Right now only steam is supported
+        struct passwd* pw = getpwuid(getuid());
+        std::string homeDir = pw->pw_dir;
 
-    std::string Path = homeDir + "/.local/share/BeamNG.drive/";
-    std::string Ver = CheckVer(GetGameDir());
-    Ver = Ver.substr(0, Ver.find('.', Ver.find('.') + 1));
-    Path += Ver + "/";
-    info("Game user path: '" + Path + "'");
+        Path = homeDir + "/.local/share/BeamNG.drive/";
+        std::string Ver = GameVersion(GetGameDir());
+        Ver = Ver.substr(0, Ver.find('.', Ver.find('.') + 1));
+        Path += Ver + "/";
+        info("Game user path: '" + Path + "'");
+    });
     return Path;
 }
 #endif
@@ -112,6 +119,7 @@ void StartGame(std::string Dir) {
 #endif
 
 void InitGame(const std::string& Dir) {
+    TraceSpan Span("InitGame");
     if (!Dev) {
         std::thread Game(StartGame, Dir);
         Game.detach();
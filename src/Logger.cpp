@@ -8,6 +8,7 @@
 
 #include "Logger.h"
 #include "Startup.h"
+#include "Trace.h"
 #include <chrono>
 #include <fstream>
 #include <sstream>
@@ -35,6 +36,7 @@ std::string getDate() {
     return date.str();
 }
 void InitLog() {
+    TraceSpan Span("InitLog");
     std::ofstream LFS;
     LFS.open(GetEP() + "Launcher.log");
     if (!LFS.is_open()) {
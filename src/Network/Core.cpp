@@ -6,6 +6,7 @@
 /// Created by Anonymous275 on 7/20/2020
 ///
 #include "Http.h"
+#include "Network/RateLimiter.h"
 #include "Network/network.hpp"
 #include "Security/Init.h"
 #include <cstdlib>
@@ -16,6 +17,7 @@
 #elif defined(__linux__)
 #include <cstring>
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <spawn.h>
 #include <sys/socket.h>
@@ -27,6 +29,8 @@
 #include "Logger.h"
 #include "Startup.h"
 #include <charconv>
+#include <condition_variable>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <set>
 #include <thread>
@@ -45,6 +49,28 @@ std::string MStatus;
 bool ModLoaded;
 int ping = -1;
 
+static std::mutex ReadyLock;
+static std::condition_variable ReadyCv;
+static bool Ready = false;
+
+void SetLauncherReady() {
+    {
+        std::scoped_lock Guard(ReadyLock);
+        Ready = true;
+    }
+    ReadyCv.notify_all();
+}
+
+bool LauncherReady() {
+    std::scoped_lock Guard(ReadyLock);
+    return Ready;
+}
+
+void WaitLauncherReady() {
+    std::unique_lock Guard(ReadyLock);
+    ReadyCv.wait(Guard, [] { return Ready; });
+}
+
 void StartSync(const std::string& Data) {
     std::string IP = GetAddr(Data.substr(1, Data.find(':') - 1));
     if (IP.find('.') == -1) {
@@ -85,7 +111,7 @@ void Parse(std::string Data, SOCKET CSocket) {
         NetReset();
         Terminate = true;
         TCPTerminate = true;
-        Data = Code + HTTP::Get("https://backend.beammp.com/servers-info");
+        Data = Code + HTTP::CachedGet("https://backend.beammp.com/servers-info");
         break;
     case 'C':
         ListOfMods.clear();
@@ -149,6 +175,16 @@ void Parse(std::string Data, SOCKET CSocket) {
     case 'M':
         Data = MStatus;
         break;
+    case 'D': // mod download limit, "Dl<KB/s>" sets it (0 = unlimited), both reply "Dr<achieved>:<configured>" in KB/s
+        if (SubCode == 'l') {
+            try {
+                DownloadLimiter.SetRate(std::stoull(Data.substr(2)) * 1024);
+            } catch (const std::exception&) {
+                error("Invalid download limit '" + Data.substr(2) + "'");
+            }
+        }
+        Data = "Dr" + std::to_string(DownloadLimiter.AchievedRate() / 1024) + ":" + std::to_string(DownloadLimiter.GetRate() / 1024);
+        break;
     case 'Q':
         if (SubCode == 'S') {
             NetReset();
@@ -234,6 +270,12 @@ void GameHandler(SOCKET Client) {
         if (Temp < 1)
             break;
 
+        // status polls only read the current status and are answered while starting, anything else waits
+        if (Ret.empty() || Ret[0] != 'U') {
+            if (!LauncherReady())
+                debug("(Core) Holding a request until the launcher is ready");
+            WaitLauncherReady();
+        }
         Parse(Ret, Client);
     } while (Temp > 0);
     if (Temp == 0) {
@@ -254,6 +296,15 @@ void localRes() {
     }
     ConfList = new std::set<std::string>;
 }
+// the game is spawned with handle inheritance on, it must not keep the core port open once the launcher is gone
+static void NoInherit(SOCKET Sock) {
+#if defined(_WIN32)
+    SetHandleInformation(HANDLE(Sock), HANDLE_FLAG_INHERIT, 0);
+#else
+    fcntl(int(Sock), F_SETFD, FD_CLOEXEC);
+#endif
+}
+
 void CoreMain() {
     debug("Core Network on start!");
     SOCKET LSocket, CSocket;
@@ -286,6 +337,7 @@ void CoreMain() {
         WSACleanup();
         return;
     }
+    NoInherit(LSocket);
     iRes = bind(LSocket, res->ai_addr, int(res->ai_addrlen));
     if (iRes == SOCKET_ERROR) {
         error("(Core) bind failed with error: " + std::to_string(WSAGetLastError()));
@@ -308,6 +360,7 @@ void CoreMain() {
             error("(Core) accept failed with error: " + std::to_string(WSAGetLastError()));
             continue;
         }
+        NoInherit(CSocket);
         localRes();
         info("Game Connected!");
         GameHandler(CSocket);
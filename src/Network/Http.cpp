@@ -12,27 +12,98 @@
 #include <filesystem>
 #include <fstream>
 #include <httplib.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <Startup.h>
+#include <Trace.h>
+#include <Network/ResponseCache.h>
+#include <Network/ServerIndex.h>
+#include <Network/TieredCache.h>
 #include <Network/network.hpp>
 #include <Utils.h>
+#include <Zlib/Compressor.h>
+
+// Failed requests are logged by a background thread so the failing caller only pays for a queue push.
+// The queue is bounded, during an outage anything beyond it is dropped and counted instead
+class HttpDebugRecorder {
+public:
+    void Push(std::string Method, nlohmann::json Entry) {
+        {
+            std::scoped_lock Guard(Lock);
+            if (Queue.size() >= MaxQueued) {
+                Dropped++;
+                return;
+            }
+            Queue.emplace_back(std::move(Method), std::move(Entry));
+            if (!Started) {
+                Started = true;
+                std::thread(&HttpDebugRecorder::Run, this).detach();
+            }
+        }
+        Cv.notify_one();
+    }
 
-void WriteHttpDebug(const httplib::Client& client, const std::string& method, const std::string& target, const httplib::Result& result) try {
-    const std::filesystem::path folder = ".https_debug";
-    std::filesystem::create_directories(folder);
-    if (!std::filesystem::exists(folder / "WHAT IS THIS FOLDER.txt")) {
-        std::ofstream ignore { folder / "WHAT IS THIS FOLDER.txt" };
-        ignore << "This folder exists to help debug current issues with the backend. Do not share this folder with anyone but BeamMP staff. It contains detailed logs of any failed http requests." << std::endl;
+private:
+    static constexpr size_t MaxQueued = 64;
+
+    void Run() {
+        while (true) {
+            std::vector<std::pair<std::string, nlohmann::json>> Batch;
+            size_t Lost;
+            {
+                std::unique_lock Guard(Lock);
+                Cv.wait(Guard, [&] { return !Queue.empty(); });
+                Batch.swap(Queue);
+                Lost = Dropped;
+                Dropped = 0;
+            }
+            if (Lost > 0)
+                debug("Dropped " + std::to_string(Lost) + " http debug entries, the recorder queue was full");
+            Write(Batch);
+        }
     }
-    const auto file = folder / (method + ".json");
-    // 1 MB limit
-    if (std::filesystem::exists(file) && std::filesystem::file_size(file) > 1'000'000) {
-        std::filesystem::rename(file, file.generic_string() + ".bak");
+
+    // every file touched by the batch is checked and opened once
+    static void Write(const std::vector<std::pair<std::string, nlohmann::json>>& Batch) try {
+        const std::filesystem::path folder = ".https_debug";
+        std::filesystem::create_directories(folder);
+        if (!std::filesystem::exists(folder / "WHAT IS THIS FOLDER.txt")) {
+            std::ofstream ignore { folder / "WHAT IS THIS FOLDER.txt" };
+            ignore << "This folder exists to help debug current issues with the backend. Do not share this folder with anyone but BeamMP staff. It contains detailed logs of any failed http requests." << std::endl;
+        }
+        std::map<std::string, std::string> Files;
+        for (const auto& [Method, Entry] : Batch)
+            Files[Method] += Entry.dump();
+        for (const auto& [Method, Data] : Files) {
+            const auto file = folder / (Method + ".json");
+            // 1 MB limit
+            if (std::filesystem::exists(file) && std::filesystem::file_size(file) > 1'000'000) {
+                std::filesystem::rename(file, file.generic_string() + ".bak");
+            }
+            std::ofstream of { file, std::ios::app };
+            of << Data;
+        }
+    } catch (const std::exception& e) {
+        error(e.what());
     }
 
-    std::ofstream of { file, std::ios::app };
+    std::mutex Lock;
+    std::condition_variable Cv;
+    std::vector<std::pair<std::string, nlohmann::json>> Queue;
+    size_t Dropped = 0;
+    bool Started = false;
+};
+
+static HttpDebugRecorder DebugRecorder;
+
+void WriteHttpDebug(const httplib::Client& client, const std::string& method, const std::string& target, const httplib::Result& result) try {
+    // the client is reused once we return, so its state is captured here
     nlohmann::json js {
         { "utc", std::chrono::system_clock::now().time_since_epoch().count() },
         { "target", target },
@@ -45,7 +116,7 @@ void WriteHttpDebug(const httplib::Client& client, const std::string& method, co
                          } },
     };
     if (result) {
-        auto value = result.value();
+        const auto& value = result.value();
         js["result"] = {};
         js["result"]["body"] = value.body;
         js["result"]["status"] = value.status;
@@ -54,75 +125,235 @@ void WriteHttpDebug(const httplib::Client& client, const std::string& method, co
         js["result"]["location"] = value.location;
         js["result"]["reason"] = value.reason;
     }
-    of << js.dump();
+    DebugRecorder.Push(method, std::move(js));
 } catch (const std::exception& e) {
     error(e.what());
 }
 
-bool HTTP::isDownload = false;
-std::string HTTP::Get(const std::string& IP) {
-    static std::mutex Lock;
-    std::scoped_lock Guard(Lock);
+// Hands out keep-alive clients per host so repeat requests skip DNS, TCP and the TLS handshake.
+// At most MaxPerHost clients of one host are in use at the same time, further callers wait for one
+class ClientPool {
+public:
+    std::unique_ptr<httplib::Client> Acquire(const std::string& Host) {
+        std::unique_lock Guard(Lock);
+        auto& Entry = Hosts[Host];
+        Cv.wait(Guard, [&] { return Entry.InUse < MaxPerHost; });
+        Entry.InUse++;
+        if (!Entry.Idle.empty()) {
+            auto Client = std::move(Entry.Idle.back());
+            Entry.Idle.pop_back();
+            return Client;
+        }
+        Guard.unlock();
+        auto Client = std::make_unique<httplib::Client>(Host);
+        Client->set_connection_timeout(std::chrono::seconds(10));
+        Client->set_keep_alive(true);
+        // bodies are decoded by us so the proxy can pass them on compressed
+        Client->set_decompress(false);
+        return Client;
+    }
+
+    void Release(const std::string& Host, std::unique_ptr<httplib::Client> Client) {
+        {
+            std::scoped_lock Guard(Lock);
+            auto& Entry = Hosts[Host];
+            Entry.InUse--;
+            if (Client->is_valid())
+                Entry.Idle.push_back(std::move(Client));
+        }
+        Cv.notify_one();
+    }
+
+    void SetMaxPerHost(size_t Max) {
+        {
+            std::scoped_lock Guard(Lock);
+            MaxPerHost = Max == 0 ? 1 : Max;
+        }
+        Cv.notify_all();
+    }
+
+private:
+    struct HostEntry {
+        std::vector<std::unique_ptr<httplib::Client>> Idle;
+        size_t InUse = 0;
+    };
+    std::mutex Lock;
+    std::condition_variable Cv;
+    std::map<std::string, HostEntry> Hosts;
+    size_t MaxPerHost = 4;
+};
+
+static ClientPool Pool;
+
+// returns the client to the pool when the request is done
+struct PooledClient {
+    PooledClient(const std::string& Host)
+        : Host(Host)
+        , Client(Pool.Acquire(Host)) { }
+    ~PooledClient() { Pool.Release(Host, std::move(Client)); }
+    httplib::Client* operator->() { return Client.get(); }
+    httplib::Client& operator*() { return *Client; }
+    std::string Host;
+    std::unique_ptr<httplib::Client> Client;
+};
+
+static long long MsSince(std::chrono::steady_clock::time_point Start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - Start).count();
+}
+
+// upstream traffic of Get and the proxy, reported by the proxy's /stats
+struct TransferStats {
+    std::atomic<uint64_t> Responses = 0, Compressed = 0;
+    std::atomic<uint64_t> WireBytes = 0, IdentityBytes = 0;
+    std::atomic<uint64_t> CompressedMs = 0, PlainMs = 0;
+    std::atomic<uint64_t> PassedThrough = 0, Decoded = 0;
+    std::atomic<uint64_t> Streamed = 0, StreamedBytes = 0;
+};
+static TransferStats Upstream;
+
+static bool IsEncoded(const std::string& Encoding) {
+    return !Encoding.empty() && Encoding != "identity";
+}
+
+static void RecordTransfer(const httplib::Result& Res, std::chrono::steady_clock::time_point Start) {
+    if (!Res)
+        return;
+    auto Ms = uint64_t(MsSince(Start));
+    const std::string& Body = Res->body;
+    auto Encoding = Res->get_header_value("Content-Encoding");
+    uint64_t Identity = Body.size();
+    if (Encoding == "gzip" && Body.size() >= 18) {
+        // the gzip trailer ends with the uncompressed size mod 2^32
+        auto End = reinterpret_cast<const uint8_t*>(Body.data() + Body.size());
+        Identity = uint64_t(End[-4]) | uint64_t(End[-3]) << 8 | uint64_t(End[-2]) << 16 | uint64_t(End[-1]) << 24;
+    }
+    Upstream.Responses++;
+    Upstream.WireBytes += Body.size();
+    Upstream.IdentityBytes += Identity;
+    if (IsEncoded(Encoding)) {
+        Upstream.Compressed++;
+        Upstream.CompressedMs += Ms;
+    } else {
+        Upstream.PlainMs += Ms;
+    }
+}
+
+template <typename F>
+static httplib::Result Timed(F&& Request) {
+    auto Start = std::chrono::steady_clock::now();
+    httplib::Result Res = Request();
+    RecordTransfer(Res, Start);
+    return Res;
+}
+
+static nlohmann::json TransferStatsJson() {
+    uint64_t Compressed = Upstream.Compressed, Plain = Upstream.Responses - Compressed;
+    uint64_t Wire = Upstream.WireBytes, Identity = Upstream.IdentityBytes;
+    return {
+        { "responses", Upstream.Responses.load() },
+        { "compressed_responses", Compressed },
+        { "wire_bytes", Wire },
+        { "identity_bytes", Identity },
+        { "saved_bytes", Identity > Wire ? Identity - Wire : 0 },
+        { "avg_compressed_ms", Compressed ? Upstream.CompressedMs / Compressed : 0 },
+        { "avg_plain_ms", Plain ? Upstream.PlainMs / Plain : 0 },
+        { "passed_through", Upstream.PassedThrough.load() },
+        { "decoded", Upstream.Decoded.load() },
+        { "streamed", Upstream.Streamed.load() },
+        { "streamed_bytes", Upstream.StreamedBytes.load() },
+    };
+}
+
+// replaces a gzip or deflate encoded Body with the decoded data
+static bool DecodeBody(const std::string& Encoding, std::string& Body) {
+    if (!IsEncoded(Encoding))
+        return true;
+    if (Encoding != "gzip" && Encoding != "deflate")
+        return false;
+    try {
+        auto Decoded = HttpDeComp(std::span<const char>(Body.data(), Body.size()));
+        Body.assign(Decoded.data(), Decoded.size());
+        return true;
+    } catch (const std::exception& e) {
+        error(e.what());
+        return false;
+    }
+}
+
+void HTTP::SetMaxConnections(size_t Max) {
+    Pool.SetMaxPerHost(Max);
+}
+
+// urls carry the public key in their query, so spans only name the path
+static std::string TraceName(const std::string& IP) {
+    return IP.substr(0, IP.find('?'));
+}
 
+std::string HTTP::Get(const std::string& IP) {
+    TraceSpan Span("GET", "http", TraceName(IP));
     auto pos = IP.find('/', 10);
 
-    httplib::Client cli(IP.substr(0, pos).c_str());
-    cli.set_connection_timeout(std::chrono::seconds(10));
-    cli.set_follow_location(true);
-    auto res = cli.Get(IP.substr(pos).c_str(), ProgressBar);
+    PooledClient cli(IP.substr(0, pos));
+    cli->set_follow_location(true);
+    bool Reused = cli->is_socket_open();
+    auto Start = std::chrono::steady_clock::now();
+    long long FirstByte = -1;
+    std::string Body;
+    auto res = cli->Get(
+        IP.substr(pos).c_str(), httplib::Headers { { "Accept-Encoding", "gzip, deflate" } },
+        [&](const httplib::Response&) {
+            FirstByte = MsSince(Start);
+            return true;
+        },
+        [&](const char* Data, size_t Len) {
+            Body.append(Data, Len);
+            return true;
+        });
     std::string Ret;
 
     if (res) {
+        res->body = std::move(Body);
+        RecordTransfer(res, Start);
+        if (!DecodeBody(res->get_header_value("Content-Encoding"), res->body))
+            res->status = 500;
+        debug("GET " + cli.Host + " ttfb " + std::to_string(FirstByte) + "ms (" + (Reused ? "reused" : "new") + " connection)");
         if (res->status == 200) {
             Ret = res->body;
         } else {
-            WriteHttpDebug(cli, "GET", IP, res);
-            error("Failed to GET '" + IP + "': " + res->reason + ", ssl verify = " + std::to_string(cli.get_openssl_verify_result()));
+            WriteHttpDebug(*cli, "GET", IP, res);
+            error("Failed to GET '" + IP + "': " + res->reason + ", ssl verify = " + std::to_string(cli->get_openssl_verify_result()));
         }
     } else {
-        if (isDownload) {
-            std::cout << "\n";
-        }
-        WriteHttpDebug(cli, "GET", IP, res);
-        error("HTTP Get failed on " + to_string(res.error()) + ", ssl verify = " + std::to_string(cli.get_openssl_verify_result()));
+        WriteHttpDebug(*cli, "GET", IP, res);
+        error("HTTP Get failed on " + to_string(res.error()) + ", ssl verify = " + std::to_string(cli->get_openssl_verify_result()));
     }
 
     return Ret;
 }
 
 std::string HTTP::Post(const std::string& IP, const std::string& Fields) {
-    static std::mutex Lock;
-    std::scoped_lock Guard(Lock);
-
+    TraceSpan Span("POST", "http", TraceName(IP));
     auto pos = IP.find('/', 10);
 
-    httplib::Client cli(IP.substr(0, pos).c_str());
-    cli.set_connection_timeout(std::chrono::seconds(10));
+    PooledClient cli(IP.substr(0, pos));
+    cli->set_follow_location(false);
+    bool Reused = cli->is_socket_open();
+    auto Start = std::chrono::steady_clock::now();
     std::string Ret;
 
-    if (!Fields.empty()) {
-        httplib::Result res = cli.Post(IP.substr(pos).c_str(), Fields, "application/json");
+    httplib::Result res = Fields.empty()
+        ? cli->Post(IP.substr(pos).c_str())
+        : cli->Post(IP.substr(pos).c_str(), Fields, "application/json");
 
-        if (res) {
-            if (res->status != 200) {
-                error(res->reason);
-            }
-            Ret = res->body;
-        } else {
-            WriteHttpDebug(cli, "POST", IP, res);
-            error("HTTP Post failed on " + to_string(res.error()) + ", ssl verify = " + std::to_string(cli.get_openssl_verify_result()));
+    if (res) {
+        debug("POST " + cli.Host + " took " + std::to_string(MsSince(Start)) + "ms (" + (Reused ? "reused" : "new") + " connection)");
+        if (res->status != 200) {
+            error(res->reason);
         }
+        Ret = res->body;
     } else {
-        httplib::Result res = cli.Post(IP.substr(pos).c_str());
-        if (res) {
-            if (res->status != 200) {
-                error(res->reason);
-            }
-            Ret = res->body;
-        } else {
-            WriteHttpDebug(cli, "POST", IP, res);
-            error("HTTP Post failed on " + to_string(res.error()) + ", ssl verify = " + std::to_string(cli.get_openssl_verify_result()));
-        }
+        WriteHttpDebug(*cli, "POST", IP, res);
+        error("HTTP Post failed on " + to_string(res.error()) + ", ssl verify = " + std::to_string(cli->get_openssl_verify_result()));
     }
 
     if (Ret.empty())
@@ -131,50 +362,277 @@ std::string HTTP::Post(const std::string& IP, const std::string& Fields) {
         return Ret;
 }
 
+// the cache entry as it is stored, still in its Content-Encoding, logs and returns a Status other than 200 on failure
+static ResponseCache::Entry CachedEntry(const std::string& IP) {
+    auto pos = IP.find('/', 10);
+    // same key the proxy uses for requests without X-API-Version
+    auto Entry = BackendCache.Get(IP + "|", [&](const httplib::Headers& Extra) {
+        PooledClient cli(IP.substr(0, pos));
+        cli->set_follow_location(true);
+        httplib::Headers Headers = Extra;
+        Headers.emplace("Accept-Encoding", "gzip, deflate");
+        return Timed([&] { return cli->Get(IP.substr(pos), Headers); });
+    });
+    if (Entry.Status != 200)
+        error("Failed to GET '" + IP + "': " + (Entry.Status == 0 ? Entry.Error : std::to_string(Entry.Status)));
+    return Entry;
+}
+
+std::string HTTP::CachedGet(const std::string& IP) {
+    auto Entry = CachedEntry(IP);
+    if (Entry.Status != 200)
+        return "";
+    std::string Body = *Entry.Body;
+    if (!DecodeBody(Entry.Encoding, Body))
+        return "";
+    return Body;
+}
+
+std::future<std::string> HTTP::GetAsync(const std::string& IP) {
+    return std::async(std::launch::async, [IP] { return Get(IP); });
+}
+
+std::future<std::string> HTTP::PostAsync(const std::string& IP, const std::string& Fields) {
+    return std::async(std::launch::async, [IP, Fields] { return Post(IP, Fields); });
+}
+
+// only Download draws it, its lock keeps two downloads from drawing at once
 bool HTTP::ProgressBar(size_t c, size_t t) {
-    if (isDownload) {
-        static double last_progress, progress_bar_adv;
-        progress_bar_adv = round(c / double(t) * 25);
-        std::cout << "\r";
-        std::cout << "Progress : [ ";
-        std::cout << round(c / double(t) * 100);
-        std::cout << "% ] [";
-        int i;
-        for (i = 0; i <= progress_bar_adv; i++)
-            std::cout << "#";
-        for (i = 0; i < 25 - progress_bar_adv; i++)
-            std::cout << ".";
-        std::cout << "]";
-        last_progress = round(c / double(t) * 100);
-    }
+    static double last_progress, progress_bar_adv;
+    progress_bar_adv = round(c / double(t) * 25);
+    std::cout << "\r";
+    std::cout << "Progress : [ ";
+    std::cout << round(c / double(t) * 100);
+    std::cout << "% ] [";
+    int i;
+    for (i = 0; i <= progress_bar_adv; i++)
+        std::cout << "#";
+    for (i = 0; i < 25 - progress_bar_adv; i++)
+        std::cout << ".";
+    std::cout << "]";
+    last_progress = round(c / double(t) * 100);
     return true;
 }
 
+static size_t DownloadParts = 4;
+// smaller files are not worth the extra connections
+static const uint64_t RangedMinSize = 8 * 1024 * 1024;
+
+void HTTP::SetDownloadParts(size_t Parts) {
+    DownloadParts = Parts == 0 ? 1 : Parts;
+}
+
+// fetches the file as Parts byte ranges at once, each written to its own offset of Part.
+// Returns false if any range fails or the server answers with the whole file instead
+static bool RangedDownload(const std::string& URL, const std::string& Part, uint64_t Size, size_t Parts, const std::string& Validator) {
+    {
+        std::ofstream File(Part, std::ios::binary | std::ios::trunc);
+        if (!File.is_open()) {
+            error("Failed to open file directory: " + Part);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::resize_file(Part, Size, ec);
+    if (ec)
+        return false;
+
+    auto pos = URL.find('/', 10);
+    std::atomic<uint64_t> Received = 0;
+    std::mutex ProgressLock;
+    std::vector<std::future<bool>> Ranges;
+    uint64_t Chunk = Size / Parts;
+    for (size_t i = 0; i < Parts; i++) {
+        uint64_t Start = i * Chunk;
+        uint64_t End = i == Parts - 1 ? Size : Start + Chunk;
+        Ranges.push_back(std::async(std::launch::async, [&, Start, End] {
+            httplib::Client cli(URL.substr(0, pos));
+            cli.set_connection_timeout(std::chrono::seconds(10));
+            std::fstream File(Part, std::ios::binary | std::ios::in | std::ios::out);
+            if (!File.is_open())
+                return false;
+            uint64_t Written = 0;
+            for (int Attempt = 0; Attempt < 5 && Start + Written < End; Attempt++) {
+                httplib::Headers Headers {
+                    { "Range", "bytes=" + std::to_string(Start + Written) + "-" + std::to_string(End - 1) }
+                };
+                if (!Validator.empty())
+                    Headers.emplace("If-Range", Validator);
+                File.seekp(std::streamoff(Start + Written));
+                auto res = cli.Get(
+                    URL.substr(pos), Headers,
+                    [&](const httplib::Response& Res) { return Res.status == 206; },
+                    [&](const char* Data, size_t Len) {
+                        if (Start + Written + Len > End)
+                            return false;
+                        File.write(Data, std::streamsize(Len));
+                        Written += Len;
+                        Received += Len;
+                        if (std::unique_lock Progress(ProgressLock, std::try_to_lock); Progress.owns_lock())
+                            HTTP::ProgressBar(Received, Size);
+                        return !File.fail();
+                    });
+                if (res && res->status != 206)
+                    return false;
+            }
+            return Start + Written == End;
+        }));
+    }
+    bool Ok = true;
+    for (auto& Range : Ranges)
+        Ok = Range.get() && Ok;
+    return Ok;
+}
+
+// streams the body into Path + ".part" and resumes with a Range request if the connection drops,
+// the finished file is renamed over Path so a failed download never leaves a broken file behind
 bool HTTP::Download(const std::string& IP, const std::string& Path) {
+    TraceSpan Span("Download", "http", TraceName(IP));
     static std::mutex Lock;
     std::scoped_lock Guard(Lock);
 
-    isDownload = true;
-    std::string Ret = Get(IP);
-    isDownload = false;
+    const std::string Part = Path + ".part";
+    std::error_code ec;
+    // we can't tell if a leftover from an earlier run is the same file
+    std::filesystem::remove(Part, ec);
 
-    if (Ret.empty())
-        return false;
+    auto pos = IP.find('/', 10);
+    PooledClient cli(IP.substr(0, pos));
+    cli->set_follow_location(true);
+
+    std::string Validator;
+    bool Done = false;
+
+    if (DownloadParts > 1) {
+        auto Head = cli->Head(IP.substr(pos));
+        if (Head && Head->status == 200 && Head->get_header_value("Accept-Ranges") == "bytes"
+            && Head->has_header("Content-Length")) {
+            uint64_t Size = std::stoull(Head->get_header_value("Content-Length"));
+            // follow_location leaves the final URL in location, it is only relative if the server sent it so
+            std::string URL = IP;
+            if (Head->location.starts_with("http"))
+                URL = Head->location;
+            else if (Head->location.starts_with("/"))
+                URL = IP.substr(0, pos) + Head->location;
+            if (Head->has_header("ETag"))
+                Validator = Head->get_header_value("ETag");
+            else if (Head->has_header("Last-Modified"))
+                Validator = Head->get_header_value("Last-Modified");
+            if (Size >= RangedMinSize) {
+                Done = RangedDownload(URL, Part, Size, DownloadParts, Validator);
+                if (!Done) {
+                    std::cout << "\n";
+                    warn("Parallel download failed, falling back to a single stream");
+                    std::filesystem::remove(Part, ec);
+                }
+            }
+        }
+    }
 
-    std::ofstream File(Path, std::ios::binary);
-    if (File.is_open()) {
-        File << Ret;
+    for (int Attempt = 0; Attempt < 5 && !Done; Attempt++) {
+        uint64_t Have = std::filesystem::exists(Part) ? std::filesystem::file_size(Part) : 0;
+        httplib::Headers Headers;
+        if (Have > 0) {
+            Headers.emplace("Range", "bytes=" + std::to_string(Have) + "-");
+            if (!Validator.empty())
+                Headers.emplace("If-Range", Validator);
+        }
+        std::ofstream File;
+        auto res = cli->Get(
+            IP.substr(pos), Headers,
+            [&](const httplib::Response& Res) {
+                if (Res.status == 206) {
+                    File.open(Part, std::ios::binary | std::ios::app);
+                } else if (Res.status == 200) {
+                    // the server ignored the range, start over
+                    Have = 0;
+                    File.open(Part, std::ios::binary | std::ios::trunc);
+                } else {
+                    return true;
+                }
+                if (Res.has_header("ETag"))
+                    Validator = Res.get_header_value("ETag");
+                else if (Res.has_header("Last-Modified"))
+                    Validator = Res.get_header_value("Last-Modified");
+                if (!File.is_open()) {
+                    error("Failed to open file directory: " + Part);
+                    return false;
+                }
+                return true;
+            },
+            [&](const char* Data, size_t Len) {
+                if (File.is_open())
+                    File.write(Data, std::streamsize(Len));
+                return !File.fail();
+            },
+            [&](uint64_t Current, uint64_t Total) {
+                return ProgressBar(Have + Current, Have + Total);
+            });
         File.close();
-        std::cout << "\n";
-        info("Download Complete!");
-    } else {
-        error("Failed to open file directory: " + Path);
+
+        if (res && (res->status == 200 || res->status == 206)) {
+            Done = true;
+        } else if (res && res->status == 416) {
+            std::filesystem::remove(Part, ec);
+        } else if (res) {
+            std::cout << "\n";
+            WriteHttpDebug(*cli, "GET", IP, res);
+            error("Failed to download '" + IP + "': " + std::to_string(res->status) + " " + res->reason);
+            break;
+        } else {
+            std::cout << "\n";
+            warn("Download interrupted (" + to_string(res.error()) + "), resuming...");
+        }
+    }
+
+    if (!Done) {
+        std::filesystem::remove(Part, ec);
+        error("Failed to download " + IP);
         return false;
     }
 
+    std::filesystem::rename(Part, Path, ec);
+    if (ec) {
+        error("Failed to move download to " + Path + ": " + ec.message());
+        return false;
+    }
+    std::cout << "\n";
+    info("Download Complete!");
     return true;
 }
 
+// avatar templates only change when a user uploads a new picture, the images behind a template never do
+static TieredCache AvatarTemplates(".avatar_cache/users", 1024, std::chrono::hours(24));
+static TieredCache AvatarImages(".avatar_cache/images", 512, std::chrono::hours(24 * 30));
+
+// passes an upstream body on as it is if the game accepts its encoding, otherwise decodes it first
+static void SendBody(const httplib::Request& req, httplib::Response& res, std::string Body, const std::string& Encoding, const std::string& Type) {
+#ifndef CPPHTTPLIB_ZLIB_SUPPORT
+    // an httplib built with zlib compresses responses on its own and would do it a second time
+    if (IsEncoded(Encoding) && req.get_header_value("Accept-Encoding").find(Encoding) != std::string::npos) {
+        Upstream.PassedThrough++;
+        res.set_header("Content-Encoding", Encoding);
+        res.set_content(std::move(Body), Type);
+        return;
+    }
+#endif
+    if (!DecodeBody(Encoding, Body)) {
+        res.status = 502;
+        res.set_content("Failed to decode upstream response", "text/plain");
+        return;
+    }
+    if (IsEncoded(Encoding))
+        Upstream.Decoded++;
+    res.set_content(std::move(Body), Type);
+}
+
+static void SendEntry(const httplib::Request& req, httplib::Response& res, const ResponseCache::Entry& Entry) {
+    if (Entry.Status == 0)
+        res.set_content(Entry.Error, "text/plain");
+    else
+        SendBody(req, res, *Entry.Body, Entry.Encoding, Entry.ContentType);
+}
+
 void set_headers(httplib::Response& res) {
     res.set_header("Access-Control-Allow-Origin", "*");
     res.set_header("Access-Control-Request-Method", "POST, OPTIONS, GET");
@@ -182,20 +640,174 @@ void set_headers(httplib::Response& res) {
 }
 
 
+static size_t ProxyThreads = 8;
+
+void HTTP::SetProxyThreads(size_t Threads) {
+    ProxyThreads = Threads == 0 ? 1 : Threads;
+}
+
+static std::atomic<bool> ProxyStreaming = true;
+
+void HTTP::SetProxyStreaming(bool Enabled) {
+    ProxyStreaming = Enabled;
+}
+
+// carries one upstream response from the thread fetching it to the proxy worker sending it on,
+// at most MaxChunks are held so memory stays flat however large the body is, unless it also fills the cache
+struct StreamRelay {
+    static constexpr size_t MaxChunks = 16;
+    std::mutex Lock;
+    std::condition_variable Cv;
+    std::deque<std::string> Chunks;
+    bool HeadReady = false, Done = false, Cancelled = false;
+    int Status = 0;
+    std::string Type, Encoding, Error;
+    std::thread Fetcher;
+    /// set when the response is stored in the backend cache once complete
+    std::shared_ptr<ResponseCache::Ticket> Fill;
+    std::string Body;
+    ResponseCache::Entry Stored;
+};
+
+static void SendEntry(const httplib::Request& req, httplib::Response& res, const ResponseCache::Entry& Entry);
+
+// answers req with the upstream GET as its chunks arrive, the head is sent as soon as upstream sends its own.
+// With Fill the whole body is also kept and stored under its ticket, a 304 or a failure is answered from the cache
+static void StreamGet(const httplib::Request& req, httplib::Response& res, const std::string& Host, const std::string& Path, httplib::Headers Headers,
+    std::shared_ptr<ResponseCache::Ticket> Fill = nullptr) {
+    auto Relay = std::make_shared<StreamRelay>();
+    Relay->Fill = std::move(Fill);
+    // chunks go out untouched, so only ask for an encoding the game can take
+    Headers.erase("Accept-Encoding");
+#ifndef CPPHTTPLIB_ZLIB_SUPPORT
+    if (req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos)
+        Headers.emplace("Accept-Encoding", "gzip");
+#endif
+
+    Relay->Fetcher = std::thread([Relay, Host, Path, Headers] {
+        PooledClient cli(Host);
+        auto Res = cli->Get(
+            Path, Headers,
+            [&](const httplib::Response& Head) {
+                std::scoped_lock Guard(Relay->Lock);
+                Relay->Status = Head.status;
+                Relay->Type = Head.get_header_value("Content-Type");
+                Relay->Encoding = Head.get_header_value("Content-Encoding");
+                Relay->HeadReady = true;
+                Relay->Cv.notify_all();
+                return !Relay->Cancelled;
+            },
+            [&](const char* Data, size_t Len) {
+                std::unique_lock Guard(Relay->Lock);
+                Relay->Cv.wait(Guard, [&] { return Relay->Chunks.size() < StreamRelay::MaxChunks || Relay->Cancelled; });
+                if (Relay->Cancelled)
+                    return false;
+                Relay->Chunks.emplace_back(Data, Len);
+                if (Relay->Fill)
+                    Relay->Body.append(Data, Len);
+                Upstream.StreamedBytes += Len;
+                Relay->Cv.notify_all();
+                return true;
+            });
+        ResponseCache::Entry Stored;
+        if (Relay->Fill) {
+            // a cancelled or broken transfer fails Res, so a partial body is never stored
+            if (Res)
+                Res->body = std::move(Relay->Body);
+            try {
+                Stored = BackendCache.Complete(*Relay->Fill, Res);
+            } catch (const std::exception& e) {
+                Stored.Error = e.what();
+            }
+        }
+        std::scoped_lock Guard(Relay->Lock);
+        if (!Res && !Relay->Cancelled)
+            Relay->Error = to_string(Res.error());
+        Relay->Stored = std::move(Stored);
+        Relay->Done = true;
+        Relay->Cv.notify_all();
+    });
+
+    std::string Type;
+    {
+        std::unique_lock Guard(Relay->Lock);
+        Relay->Cv.wait(Guard, [&] { return Relay->HeadReady || Relay->Done; });
+        if (!Relay->HeadReady || (Relay->Fill && Relay->Status == 304)) {
+            Guard.unlock();
+            Relay->Fetcher.join();
+            if (Relay->Fill)
+                SendEntry(req, res, Relay->Stored);
+            else
+                res.set_content(Relay->Error, "text/plain");
+            return;
+        }
+        res.status = Relay->Status;
+        if (IsEncoded(Relay->Encoding))
+            res.set_header("Content-Encoding", Relay->Encoding);
+        Type = Relay->Type;
+    }
+    Upstream.Streamed++;
+
+    res.set_chunked_content_provider(
+        Type,
+        [Relay](size_t, httplib::DataSink& Sink) {
+            std::unique_lock Guard(Relay->Lock);
+            Relay->Cv.wait(Guard, [&] { return !Relay->Chunks.empty() || Relay->Done; });
+            if (Relay->Chunks.empty()) {
+                // a failed upstream must not look like a complete body
+                bool Complete = Relay->Error.empty();
+                Guard.unlock();
+                if (Complete)
+                    Sink.done();
+                return Complete;
+            }
+            std::string Chunk = std::move(Relay->Chunks.front());
+            Relay->Chunks.pop_front();
+            Relay->Cv.notify_all();
+            Guard.unlock();
+            return Sink.write(Chunk.data(), Chunk.size());
+        },
+        [Relay](bool) {
+            {
+                std::scoped_lock Guard(Relay->Lock);
+                Relay->Cancelled = true;
+                Relay->Cv.notify_all();
+            }
+            if (Relay->Fetcher.joinable())
+                Relay->Fetcher.join();
+        });
+}
+
+// every proxy worker keeps its own upstream connections, so parallel requests never share a client
+static httplib::Client& WorkerClient(const std::string& Host) {
+    thread_local std::map<std::string, std::unique_ptr<httplib::Client>> Clients;
+    auto& Client = Clients[Host];
+    if (!Client) {
+        Client = std::make_unique<httplib::Client>(Host);
+        Client->set_connection_timeout(std::chrono::seconds(10));
+        Client->set_keep_alive(true);
+        Client->set_decompress(false);
+    }
+    return *Client;
+}
+
 void HTTP::StartProxy() {
     std::thread proxy([&]() {
         httplib::Server HTTPProxy;
-        httplib::Headers headers = {
+        HTTPProxy.new_task_queue = [] { return new httplib::ThreadPool(ProxyThreads); };
+        const httplib::Headers base_headers = {
             { "User-Agent", "BeamMP-Launcher/" + GetVer() + GetPatch() },
-            { "Accept", "*/*" }
+            { "Accept", "*/*" },
+            { "Accept-Encoding", "gzip, deflate" }
         };
-        httplib::Client backend("https://backend.beammp.com");
-        httplib::Client forum("https://forum.beammp.com");
 
         const std::string pattern = ".*";
 
         auto handle_request = [&](const httplib::Request& req, httplib::Response& res) {
             set_headers(res);
+            httplib::Client& backend = WorkerClient("https://backend.beammp.com");
+            httplib::Client& forum = WorkerClient("https://forum.beammp.com");
+            httplib::Headers headers = base_headers;
             if (req.has_header("X-BMP-Authentication")) {
                 headers.emplace("X-BMP-Authentication", PrivateKey);
             }
@@ -215,10 +827,35 @@ void HTTP::StartProxy() {
             if (host == "backend") {
                 std::string remaining_path = req.path.substr(std::strlen("/backend"));
 
-                if (method == "GET")
-                    cli_res = backend.Get(remaining_path, headers);
+                // authenticated responses are per user and never cached
+                bool Cacheable = !req.has_header("X-BMP-Authentication") && BackendCache.Enabled();
+                if (method == "GET" && !Cacheable && ProxyStreaming) {
+                    StreamGet(req, res, "https://backend.beammp.com", remaining_path, headers);
+                    return;
+                } else if (method == "GET" && Cacheable) {
+                    auto Key = "https://backend.beammp.com" + remaining_path + "|" + req.get_header_value("X-API-Version");
+                    if (!ProxyStreaming) {
+                        SendEntry(req, res, BackendCache.Get(Key, [&](const httplib::Headers& Extra) {
+                            httplib::Headers Conditional = headers;
+                            Conditional.insert(Extra.begin(), Extra.end());
+                            return Timed([&] { return backend.Get(remaining_path, Conditional); });
+                        }));
+                        return;
+                    }
+                    // a miss is passed on while it arrives and stored once complete, concurrent misses wait for it
+                    auto Ticket = std::make_shared<ResponseCache::Ticket>();
+                    if (auto Entry = BackendCache.Begin(Key, *Ticket)) {
+                        SendEntry(req, res, *Entry);
+                        return;
+                    }
+                    httplib::Headers Conditional = headers;
+                    Conditional.insert(Ticket->Extra.begin(), Ticket->Extra.end());
+                    StreamGet(req, res, "https://backend.beammp.com", remaining_path, Conditional, Ticket);
+                    return;
+                } else if (method == "GET")
+                    cli_res = Timed([&] { return backend.Get(remaining_path, headers); });
                 else if (method == "POST")
-                    cli_res = backend.Post(remaining_path, headers);
+                    cli_res = Timed([&] { return backend.Post(remaining_path, headers); });
 
             } else if (host == "avatar") {
                 bool error = false;
@@ -239,46 +876,112 @@ void HTTP::StartProxy() {
                     } catch (std::exception&) {}
                 }
 
-                httplib::Result summary_res;
-
-                if (!error) {
-                    summary_res = forum.Get("/u/" + username + ".json", headers);
+                auto FetchImage = [&](const std::string& Link) {
+                    return AvatarImages.Get(Link, [&]() -> std::optional<TieredCache::Blob> {
+                        auto image_res = Timed([&] { return forum.Get(Link, headers); });
+                        if (!image_res || image_res->status != 200
+                            || !DecodeBody(image_res->get_header_value("Content-Encoding"), image_res->body))
+                            return std::nullopt;
+                        return TieredCache::Blob { image_res->body, image_res->get_header_value("Content-Type") };
+                    });
+                };
 
-                    if (!summary_res || summary_res->status != 200) {
-                        error = true;
-                    }
-                }
+                std::optional<TieredCache::Blob> avatar;
 
                 if (!error) {
-                    try {
+                    auto avatar_template = AvatarTemplates.Get(username, [&]() -> std::optional<TieredCache::Blob> {
+                        auto summary_res = Timed([&] { return forum.Get("/u/" + username + ".json", headers); });
+                        if (!summary_res || summary_res->status != 200
+                            || !DecodeBody(summary_res->get_header_value("Content-Encoding"), summary_res->body))
+                            return std::nullopt;
+
                         nlohmann::json d = nlohmann::json::parse(summary_res->body, nullptr, false); // can fail with parse_error
 
                         auto user = d.at("user"); // can fail with out_of_range
                         auto avatar_link_json = user.at("avatar_template"); // can fail with out_of_range
 
-                        auto avatar_link = avatar_link_json.get<std::string>();
+                        return TieredCache::Blob { avatar_link_json.get<std::string>(), "" };
+                    });
+
+                    if (avatar_template) {
+                        auto avatar_link = avatar_template->Data;
                         size_t start_pos = avatar_link.find("{size}");
                         if (start_pos != std::string::npos)
                             avatar_link.replace(start_pos, std::strlen("{size}"), avatar_size);
 
-                        cli_res = forum.Get(avatar_link, headers);
-
-                    } catch (std::exception&) {
-                        error = true;
+                        avatar = FetchImage(avatar_link);
                     }
                 }
 
-                if (error) {
-                    cli_res = forum.Get("/user_avatar/forum.beammp.com/user/0/0.png", headers);
+                if (!avatar) {
+                    avatar = FetchImage("/user_avatar/forum.beammp.com/user/0/0.png");
                 }
 
+                if (avatar)
+                    res.set_content(avatar->Data, avatar->Type);
+                else
+                    res.set_content("Avatar not found", "text/plain");
+                return;
+
+            } else if (host == "servers") {
+                // one page of the server list, e.g. /servers?q=utah&sort=players&notfull=1&offset=0&limit=50
+                auto List = CachedEntry("https://backend.beammp.com/servers-info");
+                if (List.Status != 200) {
+                    res.status = 502;
+                    res.set_content("Failed to fetch the server list", "text/plain");
+                    return;
+                }
+                // only a new body is decoded and indexed, pages of an unchanged list cost a lookup
+                if (!ServerList.IsCurrent(List.Generation)) {
+                    std::string Json = *List.Body;
+                    if (DecodeBody(List.Encoding, Json))
+                        ServerList.Update(Json, List.Generation);
+                }
+
+                auto Flag = [&](const char* Key) {
+                    auto Value = req.get_param_value(Key);
+                    return Value == "1" || Value == "true";
+                };
+                auto Number = [&](const char* Key, size_t Default) {
+                    try {
+                        return req.has_param(Key) ? size_t(std::stoul(req.get_param_value(Key))) : Default;
+                    } catch (const std::exception&) {
+                        return Default;
+                    }
+                };
+                ServerIndex::Query Q;
+                Q.Text = req.get_param_value("q");
+                Q.Map = req.get_param_value("map");
+                Q.Version = req.get_param_value("version");
+                if (req.has_param("sort"))
+                    Q.Sort = req.get_param_value("sort");
+                // players sort busiest first, the text sorts go A to Z unless asked otherwise
+                Q.Descending = req.has_param("order") ? req.get_param_value("order") == "desc" : Q.Sort == "players";
+                Q.OfficialOnly = Flag("official");
+                Q.HideFull = Flag("notfull");
+                Q.HideEmpty = Flag("notempty");
+                Q.HidePassword = Flag("nopassword");
+                Q.Offset = Number("offset", 0);
+                Q.Limit = std::min<size_t>(Number("limit", 50), 500);
+                res.set_content(ServerList.Find(Q), "application/json");
+                return;
+            } else if (host == "trace") {
+                res.set_content(Trace::Json(), "application/json");
+                return;
+            } else if (host == "stats") {
+                nlohmann::json Stats {
+                    { "backend_cache", BackendCache.Stats() },
+                    { "upstream", TransferStatsJson() },
+                };
+                res.set_content(Stats.dump(), "application/json");
+                return;
             } else {
                 res.set_content("Host not found", "text/plain");
                 return;
             }
 
             if (cli_res) {
-                res.set_content(cli_res->body, cli_res->get_header_value("Content-Type"));
+                SendBody(req, res, std::move(cli_res->body), cli_res->get_header_value("Content-Encoding"), cli_res->get_header_value("Content-Type"));
             } else {
                 res.set_content(to_string(cli_res.error()), "text/plain");
             }
@@ -294,6 +997,8 @@ void HTTP::StartProxy() {
 
         ProxyPort = HTTPProxy.bind_to_any_port("0.0.0.0");
         debug("HTTP Proxy listening on port " + std::to_string(ProxyPort));
+        // connections wait in the backlog until the login and the mod update are done
+        WaitLauncherReady();
         HTTPProxy.listen_after_bind();
     });
     proxy.detach();
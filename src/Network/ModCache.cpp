@@ -0,0 +1,158 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Network/ModCache.h"
+#include "Logger.h"
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <set>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static const fs::path CacheDir = "Resources";
+static const fs::path IndexFile = CacheDir / "index.json";
+
+static std::mutex Lock;
+static std::condition_variable Wake;
+static nlohmann::json Index = nlohmann::json::object();
+static std::set<std::string> Session;
+static uint64_t Budget = 0;
+static bool Loaded = false;
+
+static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// mods that were cached before the index existed fall back to their write time
+static int64_t WriteTime(const fs::path& Path) {
+    auto Sys = fs::last_write_time(Path) - fs::file_time_type::clock::now() + std::chrono::system_clock::now();
+    return std::chrono::duration_cast<std::chrono::seconds>(Sys.time_since_epoch()).count();
+}
+
+static void LoadIndex() {
+    if (Loaded)
+        return;
+    Loaded = true;
+    std::ifstream File(IndexFile);
+    if (!File.is_open())
+        return;
+    nlohmann::json d = nlohmann::json::parse(File, nullptr, false);
+    if (!d.is_discarded() && d.is_object())
+        Index = std::move(d);
+}
+
+static void SaveIndex() {
+    if (!fs::exists(CacheDir))
+        return;
+    fs::path Tmp = IndexFile;
+    Tmp += ".tmp";
+    std::ofstream File(Tmp, std::ios::trunc);
+    if (!File.is_open())
+        return;
+    File << Index.dump();
+    File.close();
+    std::error_code ec;
+    fs::rename(Tmp, IndexFile, ec);
+}
+
+static int64_t LastUse(const fs::path& Path) {
+    auto Name = Path.filename().string();
+    if (Index.contains(Name) && Index[Name].contains("last_use"))
+        return Index[Name]["last_use"].get<int64_t>();
+    return WriteTime(Path);
+}
+
+// removes at most one mod per call so the collector never holds the lock for long
+static bool EvictOne() {
+    std::scoped_lock Guard(Lock);
+    if (Budget == 0 || !fs::exists(CacheDir))
+        return false;
+    uint64_t Total = 0;
+    fs::path Oldest;
+    int64_t OldestUse = INT64_MAX;
+    for (const auto& Entry : fs::directory_iterator(CacheDir)) {
+        if (!Entry.is_regular_file() || Entry.path().extension() != ".zip")
+            continue;
+        Total += Entry.file_size();
+        auto Name = Entry.path().filename().string();
+        if (Session.contains(Name))
+            continue;
+        auto Use = LastUse(Entry.path());
+        if (Use < OldestUse) {
+            OldestUse = Use;
+            Oldest = Entry.path();
+        }
+    }
+    if (Total <= Budget || Oldest.empty())
+        return false;
+    std::error_code ec;
+    auto Size = fs::file_size(Oldest, ec);
+    if (!fs::remove(Oldest, ec)) {
+        warn("Failed to evict cached mod " + Oldest.filename().string());
+        return false;
+    }
+    debug("Evicted cached mod " + Oldest.filename().string() + " (" + std::to_string(Size / 1024) + " KB)");
+    Index.erase(Oldest.filename().string());
+    SaveIndex();
+    return true;
+}
+
+static void Collector() {
+    while (true) {
+        try {
+            while (EvictOne())
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        } catch (const std::exception& e) {
+            warn("Mod cache collector: " + std::string(e.what()));
+        }
+        std::unique_lock Guard(Lock);
+        Wake.wait_for(Guard, std::chrono::minutes(5));
+    }
+}
+
+void ModCache::SetBudget(uint64_t Bytes) {
+    std::scoped_lock Guard(Lock);
+    Budget = Bytes;
+}
+
+void ModCache::StartCollector() {
+    {
+        std::scoped_lock Guard(Lock);
+        if (Budget == 0)
+            return;
+        LoadIndex();
+    }
+    std::thread GC(Collector);
+    GC.detach();
+}
+
+void ModCache::BeginSession(const std::vector<std::string>& Names) {
+    std::scoped_lock Guard(Lock);
+    LoadIndex();
+    Session.clear();
+    for (const auto& Name : Names)
+        Session.insert(fs::path(Name).filename().string());
+}
+
+void ModCache::Use(const std::string& Name, const std::string& Digest) {
+    std::scoped_lock Guard(Lock);
+    auto& Entry = Index[fs::path(Name).filename().string()];
+    Entry["last_use"] = Now();
+    if (!Digest.empty())
+        Entry["stripe_sha256"] = Digest;
+}
+
+void ModCache::EndSession() {
+    {
+        std::scoped_lock Guard(Lock);
+        SaveIndex();
+    }
+    Wake.notify_one();
+}
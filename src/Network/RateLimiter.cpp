@@ -0,0 +1,77 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Network/RateLimiter.h"
+#include <algorithm>
+#include <thread>
+
+RateLimiter DownloadLimiter;
+
+// the bucket holds at most 100ms worth of data so bursts stay short
+static uint64_t BucketSize(uint64_t Rate) {
+    return std::max<uint64_t>(Rate / 10, 16 * 1024);
+}
+
+void RateLimiter::SetRate(uint64_t BytesPerSec) {
+    std::scoped_lock Guard(Lock);
+    Rate = BytesPerSec;
+    Tokens = 0;
+    LastRefill = std::chrono::steady_clock::now();
+}
+
+uint64_t RateLimiter::GetRate() {
+    std::scoped_lock Guard(Lock);
+    return Rate;
+}
+
+uint64_t RateLimiter::Acquire(uint64_t Wanted) {
+    std::chrono::duration<double> Wait {};
+    uint64_t Granted;
+    {
+        std::scoped_lock Guard(Lock);
+        if (Rate == 0)
+            return Wanted;
+        uint64_t Burst = BucketSize(Rate);
+        Granted = std::min(Wanted, Burst);
+
+        auto Now = std::chrono::steady_clock::now();
+        Tokens += std::chrono::duration<double>(Now - LastRefill).count() * double(Rate);
+        Tokens = std::min(Tokens, double(Burst));
+        LastRefill = Now;
+
+        // tokens may go negative, that reserves the bytes and every later caller waits behind us
+        Tokens -= double(Granted);
+        if (Tokens < 0)
+            Wait = std::chrono::duration<double>(-Tokens / double(Rate));
+    }
+    if (Wait.count() > 0)
+        std::this_thread::sleep_for(Wait);
+    return Granted;
+}
+
+void RateLimiter::Refund(uint64_t Bytes) {
+    std::scoped_lock Guard(Lock);
+    if (Rate != 0)
+        Tokens += double(Bytes);
+}
+
+void RateLimiter::Record(uint64_t Bytes) {
+    std::scoped_lock Guard(Lock);
+    Measured += Bytes;
+}
+
+void RateLimiter::StartMeasure() {
+    std::scoped_lock Guard(Lock);
+    Measured = 0;
+    MeasureStart = std::chrono::steady_clock::now();
+}
+
+uint64_t RateLimiter::AchievedRate() {
+    std::scoped_lock Guard(Lock);
+    double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - MeasureStart).count();
+    if (Elapsed <= 0)
+        return 0;
+    return uint64_t(double(Measured) / Elapsed);
+}
@@ -7,6 +7,10 @@
 ///
 
 #include "Network/network.hpp"
+#include "Network/ModCache.h"
+#include "Network/RateLimiter.h"
+#include "Network/ZipVerifier.h"
+#include "Security/Sha256.h"
 
 #if defined(_WIN32)
 #include <ws2tcpip.h>
@@ -14,9 +18,11 @@
 #include <arpa/inet.h>
 #include <cstring>
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 #endif
 
 #include "Logger.h"
@@ -24,6 +30,7 @@
 #include <atomic>
 #include <cmath>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <future>
@@ -122,31 +129,124 @@ void AsyncUpdate(uint64_t& Rcv, uint64_t Size, const std::string& Name) {
     } while (!Terminate && Rcv < Size);
 }
 
-char* TCPRcvRaw(SOCKET Sock, uint64_t& GRcv, uint64_t Size) {
-    if (Sock == -1) {
+void SocketClosed(SOCKET Sock, int32_t Code) {
+    info(std::to_string(Code));
+    UUl("Socket Closed Code 1");
+    KillSocket(Sock);
+    Terminate = true;
+}
+
+#if defined(__linux__)
+// moves socket data into the file through a pipe, returns how many bytes were written before splice
+// gave up or -1 if the socket failed. This is not zero-copy: every chunk is read back with pread to hash it
+// while it is still in the page cache, which saves only the write copy of BufferedRcv at the cost of
+// more syscalls. RecvBench in bench/ measures whether that pays off
+int64_t SpliceRcv(SOCKET Sock, int Fd, uint64_t Offset, uint64_t Size, uint64_t& GRcv, Sha256& Hash) {
+    int Pipe[2];
+    if (pipe(Pipe) != 0)
+        return 0;
+    fcntl(Pipe[1], F_SETPIPE_SZ, 1 << 20);
+    int PipeSize = fcntl(Pipe[1], F_GETPIPE_SZ);
+    if (PipeSize < 1)
+        PipeSize = 65536;
+    loff_t Off = loff_t(Offset);
+    std::vector<char> Buffer(PipeSize);
+    uint64_t Rcv = 0;
+    while (Rcv < Size && !Terminate) {
+        uint64_t Len = Size - Rcv;
+        if (Len > uint64_t(PipeSize))
+            Len = PipeSize;
+        uint64_t Granted = DownloadLimiter.Acquire(Len);
+        ssize_t In = splice(int(Sock), nullptr, Pipe[1], nullptr, Granted, SPLICE_F_MOVE);
+        if (In < 0 && Rcv == 0 && errno == EINVAL) {
+            DownloadLimiter.Refund(Granted);
+            break;
+        }
+        if (In < 1) {
+            SocketClosed(Sock, int32_t(In));
+            close(Pipe[0]);
+            close(Pipe[1]);
+            return -1;
+        }
+        DownloadLimiter.Refund(Granted - In);
+        for (ssize_t Left = In; Left > 0;) {
+            ssize_t Out = splice(Pipe[0], nullptr, Fd, &Off, Left, SPLICE_F_MOVE);
+            if (Out < 1) {
+                error("Failed to write downloaded data: " + std::string(strerror(errno)));
+                Terminate = true;
+                close(Pipe[0]);
+                close(Pipe[1]);
+                return -1;
+            }
+            Left -= Out;
+        }
+        if (pread(Fd, Buffer.data(), In, loff_t(Offset + Rcv)) != In) {
+            error("Failed to read back downloaded data: " + std::string(strerror(errno)));
+            Terminate = true;
+            close(Pipe[0]);
+            close(Pipe[1]);
+            return -1;
+        }
+        Hash.Update(Buffer.data(), In);
+        Rcv += In;
+        GRcv += In;
+        DownloadLimiter.Record(In);
+    }
+    close(Pipe[0]);
+    close(Pipe[1]);
+    return int64_t(Rcv);
+}
+#endif
+
+bool BufferedRcv(SOCKET Sock, const std::string& Path, uint64_t Offset, uint64_t Size, uint64_t& GRcv, Sha256& Hash) {
+    std::fstream File(Path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!File.is_open()) {
+        error("Failed to open " + Path);
         Terminate = true;
-        UUl("Invalid Socket");
-        return nullptr;
+        return false;
     }
-    char* File = new char[Size];
+    File.seekp(std::streamoff(Offset));
+    std::vector<char> Buffer(Size > 1000000 ? 1000000 : Size);
     uint64_t Rcv = 0;
-    do {
-        int Len = int(Size - Rcv);
-        if (Len > 1000000)
-            Len = 1000000;
-        int32_t Temp = recv(Sock, &File[Rcv], Len, MSG_WAITALL);
+    while (Rcv < Size && !Terminate) {
+        int Len = int(Size - Rcv > Buffer.size() ? Buffer.size() : Size - Rcv);
+        Len = int(DownloadLimiter.Acquire(Len));
+        int32_t Temp = recv(Sock, Buffer.data(), Len, MSG_WAITALL);
         if (Temp < 1) {
-            info(std::to_string(Temp));
-            UUl("Socket Closed Code 1");
-            KillSocket(Sock);
-            Terminate = true;
-            delete[] File;
-            return nullptr;
+            SocketClosed(Sock, Temp);
+            return false;
         }
+        File.write(Buffer.data(), Temp);
+        Hash.Update(Buffer.data(), Temp);
         Rcv += Temp;
         GRcv += Temp;
-    } while (Rcv < Size && !Terminate);
-    return File;
+        DownloadLimiter.Record(Temp);
+    }
+    return true;
+}
+
+// writes Size bytes from the socket into the file at Offset and feeds them to Hash in order
+bool TCPRcvToFile(SOCKET Sock, const std::string& Path, uint64_t Offset, uint64_t Size, uint64_t& GRcv, Sha256& Hash) {
+    if (Sock == -1) {
+        Terminate = true;
+        UUl("Invalid Socket");
+        return false;
+    }
+#if defined(__linux__)
+    int Fd = open(Path.c_str(), O_RDWR);
+    if (Fd != -1) {
+        int64_t Moved = SpliceRcv(Sock, Fd, Offset, Size, GRcv, Hash);
+        close(Fd);
+        if (Moved < 0)
+            return false;
+        if (uint64_t(Moved) == Size || Terminate)
+            return true;
+        debug("splice is not supported here, falling back to buffered download");
+        Offset += Moved;
+        Size -= Moved;
+    }
+#endif
+    return BufferedRcv(Sock, Path, Offset, Size, GRcv, Hash);
 }
 void MultiKill(SOCKET Sock, SOCKET Sock1) {
     KillSocket(Sock1);
@@ -178,44 +278,61 @@ SOCKET InitDSock() {
     return DSock;
 }
 
-std::string MultiDownload(SOCKET MSock, SOCKET DSock, uint64_t Size, const std::string& Name) {
+// each socket receives one half of the file straight into its place on disk.
+// Digest is sha256(sha256(first half) + sha256(second half)) so both halves can be hashed while they arrive
+bool MultiDownload(SOCKET MSock, SOCKET DSock, uint64_t Size, const std::string& Name, const std::string& Path, std::string& Digest) {
 
     uint64_t GRcv = 0, MSize = Size / 2, DSize = Size - MSize;
 
+    {
+        std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+        if (!File.is_open()) {
+            error("Failed to open " + Path);
+            MultiKill(MSock, DSock);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::resize_file(Path, Size, ec);
+    if (ec) {
+        error("Failed to allocate " + Path + ": " + ec.message());
+        MultiKill(MSock, DSock);
+        return false;
+    }
+
     std::thread Au(AsyncUpdate, std::ref(GRcv), Size, Name);
 
-    std::packaged_task<char*()> task([&] { return TCPRcvRaw(MSock, GRcv, MSize); });
-    std::future<char*> f1 = task.get_future();
+    Sha256 MHash, DHash;
+    std::packaged_task<bool()> task([&] { return TCPRcvToFile(MSock, Path, 0, MSize, GRcv, MHash); });
+    std::future<bool> f1 = task.get_future();
     std::thread Dt(std::move(task));
     Dt.detach();
 
-    char* DData = TCPRcvRaw(DSock, GRcv, DSize);
-
-    if (!DData) {
+    bool DOk = TCPRcvToFile(DSock, Path, MSize, DSize, GRcv, DHash);
+    if (!DOk)
         MultiKill(MSock, DSock);
-        return "";
-    }
 
-    f1.wait();
-    char* MData = f1.get();
-
-    if (!MData) {
+    bool MOk = f1.get();
+    if (DOk && !MOk)
         MultiKill(MSock, DSock);
-        return "";
-    }
 
     if (Au.joinable())
         Au.join();
 
-    /// omg yes very ugly my god but i was in a rush will revisit
-    std::string Ret(Size, 0);
-    memcpy(&Ret[0], MData, MSize);
-    delete[] MData;
+    if (uint64_t Limit = DownloadLimiter.GetRate(); Limit != 0) {
+        debug("Download rate " + std::to_string(DownloadLimiter.AchievedRate() / 1024) + " KB/s (limit "
+            + std::to_string(Limit / 1024) + " KB/s)");
+    }
 
-    memcpy(&Ret[MSize], DData, DSize);
-    delete[] DData;
+    if (!DOk || !MOk)
+        return false;
 
-    return Ret;
+    Sha256 Combined;
+    auto MDigest = MHash.Final(), DDigest = DHash.Final();
+    Combined.Update(MDigest.data(), MDigest.size());
+    Combined.Update(DDigest.data(), DDigest.size());
+    Digest = Sha256::Hex(Combined.Final());
+    return true;
 }
 
 void InvalidResource(const std::string& File) {
@@ -224,6 +341,87 @@ void InvalidResource(const std::string& File) {
     Terminate = true;
 }
 
+bool DownloadMod(SOCKET Sock, SOCKET DSock, const std::string& FN, uint64_t Size, const std::string& Path, const std::string& Name, std::string& Digest) {
+    std::string FName = Path.substr(Path.find_last_of('/'));
+    TCPSend("f" + FN, Sock);
+
+    std::string Data = TCPRcv(Sock);
+    if (Data == "CO" || Terminate) {
+        Terminate = true;
+        UUl("Server cannot find " + FName);
+        return false;
+    }
+
+    // the file is preallocated to Size, so it only gets its real name once both halves arrived,
+    // otherwise a cut off download would look like a cached mod on the next sync
+    std::string Part = Path + ".part";
+    std::error_code ec;
+    if (!MultiDownload(Sock, DSock, Size, Name, Part, Digest) || Terminate) {
+        fs::remove(Part, ec);
+        return false;
+    }
+    fs::rename(Part, Path, ec);
+    if (ec) {
+        error("Failed to move " + Part + " to " + Path + ": " + ec.message());
+        fs::remove(Part, ec);
+        Terminate = true;
+        return false;
+    }
+    return true;
+}
+
+struct PendingMod {
+    std::string Path;
+    std::string FName;
+    std::string FN;
+    uint64_t Size;
+    int Pos;
+    bool Cached;
+    std::string Digest;
+    std::future<bool> Valid;
+};
+
+void InstallMod(PendingMod& Mod, SOCKET Sock, SOCKET DSock, int Amount) {
+    std::string Progress = std::to_string(Mod.Pos) + "/" + std::to_string(Amount) + ": " + Mod.FName;
+    if (!Mod.Valid.get()) {
+        warn("Mod \"" + Mod.FName.substr(1) + "\" is corrupted, downloading it again");
+        remove(Mod.Path.c_str());
+        if (!DownloadMod(Sock, DSock, Mod.FN, Mod.Size, Mod.Path, Progress, Mod.Digest))
+            return;
+        if (!VerifyZip(Mod.Path, ModCRCCheck)) {
+            remove(Mod.Path.c_str());
+            UUl("Corrupted mod \"" + Mod.FName.substr(1) + "\"");
+            Terminate = true;
+            return;
+        }
+    }
+    UpdateUl(false, Progress);
+    if (Mod.Cached)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    try {
+        if (!fs::exists(GetGamePath() + "mods/multiplayer")) {
+            fs::create_directories(GetGamePath() + "mods/multiplayer");
+        }
+        auto modname = Mod.FName;
+#if defined(__linux__)
+        // Linux version of the game doesnt support uppercase letters in mod names
+        for (char& c : modname) {
+            c = ::tolower(c);
+        }
+#endif
+        auto name = GetGamePath() + "mods/multiplayer" + modname;
+        auto tmp_name = name + ".tmp";
+        fs::copy_file(Mod.Path, tmp_name, fs::copy_options::overwrite_existing);
+        fs::rename(tmp_name, name);
+    } catch (std::exception& e) {
+        error("Failed copy to the mods folder! " + std::string(e.what()));
+        Terminate = true;
+        return;
+    }
+    ModCache::Use(Mod.Path, Mod.Digest);
+    WaitForConfirm();
+}
+
 void SyncResources(SOCKET Sock) {
     std::string Ret = Auth(Sock);
     if (Ret.empty())
@@ -237,6 +435,7 @@ void SyncResources(SOCKET Sock) {
     std::vector<std::string> FSizes(list.begin() + (list.size() / 2), list.end());
     list.clear();
     Ret.clear();
+    ModCache::BeginSession(FNames);
 
     int Amount = 0, Pos = 0;
     std::string a, t;
@@ -263,7 +462,22 @@ void SyncResources(SOCKET Sock) {
     }
     if (!FNames.empty())
         info("Syncing...");
+    DownloadLimiter.StartMeasure();
     SOCKET DSock = InitDSock();
+    unsigned Workers = std::thread::hardware_concurrency() / 2;
+    ZipVerifier Verifier(Workers < 2 ? 2 : Workers);
+    std::deque<PendingMod> Pending;
+    // installs verified mods in order, keeping at most one job per worker in flight
+    auto Flush = [&](bool All) {
+        while (!Pending.empty() && !Terminate) {
+            auto& Front = Pending.front();
+            if (!All && Pending.size() <= Verifier.WorkerCount()
+                && Front.Valid.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                break;
+            InstallMod(Front, Sock, DSock, Amount);
+            Pending.pop_front();
+        }
+    };
     for (auto FN = FNames.begin(), FS = FSizes.begin(); FN != FNames.end() && !Terminate; ++FN, ++FS) {
         auto pos = FN->find_last_of('/');
         if (pos != std::string::npos) {
@@ -271,80 +485,26 @@ void SyncResources(SOCKET Sock) {
         } else
             continue;
         Pos++;
-        if (fs::exists(a)) {
-            if (FS->find_first_not_of("0123456789") != std::string::npos)
-                continue;
-            if (fs::file_size(a) == std::stoull(*FS)) {
-                UpdateUl(false, std::to_string(Pos) + "/" + std::to_string(Amount) + ": " + a.substr(a.find_last_of('/')));
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                try {
-                    if (!fs::exists(GetGamePath() + "mods/multiplayer")) {
-                        fs::create_directories(GetGamePath() + "mods/multiplayer");
-                    }
-                    auto modname = a.substr(a.find_last_of('/'));
-#if defined(__linux__)
-                    // Linux version of the game doesnt support uppercase letters in mod names
-                    for (char& c : modname) {
-                        c = ::tolower(c);
-                    }
-#endif
-                    auto name = GetGamePath() + "mods/multiplayer" + modname;
-                    auto tmp_name = name + ".tmp";
-                    fs::copy_file(a, tmp_name, fs::copy_options::overwrite_existing);
-                    fs::rename(tmp_name, name);
-                } catch (std::exception& e) {
-                    error("Failed copy to the mods folder! " + std::string(e.what()));
-                    Terminate = true;
-                    continue;
-                }
-                WaitForConfirm();
-                continue;
-            } else
-                remove(a.c_str());
-        }
-        CheckForDir();
+        if (FS->find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        uint64_t Size = std::stoull(*FS);
         std::string FName = a.substr(a.find_last_of('/'));
-        do {
-            TCPSend("f" + *FN, Sock);
-
-            std::string Data = TCPRcv(Sock);
-            if (Data == "CO" || Terminate) {
-                Terminate = true;
-                UUl("Server cannot find " + FName);
-                break;
-            }
-
+        bool Cached = fs::exists(a) && fs::file_size(a) == Size;
+        std::string Digest;
+        if (!Cached) {
+            if (fs::exists(a))
+                remove(a.c_str());
+            CheckForDir();
             std::string Name = std::to_string(Pos) + "/" + std::to_string(Amount) + ": " + FName;
-
-            Data = MultiDownload(Sock, DSock, std::stoull(*FS), Name);
-
-            if (Terminate)
+            if (!DownloadMod(Sock, DSock, *FN, Size, a, Name, Digest))
                 break;
-            UpdateUl(false, std::to_string(Pos) + "/" + std::to_string(Amount) + ": " + FName);
-            std::ofstream LFS;
-            LFS.open(a.c_str(), std::ios_base::app | std::ios::binary);
-            if (LFS.is_open()) {
-                LFS.write(&Data[0], Data.size());
-                LFS.close();
-            }
-
-        } while (fs::file_size(a) != std::stoull(*FS) && !Terminate);
-        if (!Terminate) {
-            if (!fs::exists(GetGamePath() + "mods/multiplayer")) {
-                fs::create_directories(GetGamePath() + "mods/multiplayer");
-            }
-
-// Linux version of the game doesnt support uppercase letters in mod names
-#if defined(__linux__)
-            for (char& c : FName) {
-                c = ::tolower(c);
-            }
-#endif
-
-            fs::copy_file(a, GetGamePath() + "mods/multiplayer" + FName, fs::copy_options::overwrite_existing);
+            debug("Downloaded " + FName.substr(1) + " stripe sha256 " + Digest);
         }
-        WaitForConfirm();
+        Pending.push_back({ a, FName, *FN, Size, Pos, Cached, Digest, Verifier.Submit(a) });
+        Flush(false);
     }
+    Flush(true);
+    ModCache::EndSession();
     KillSocket(DSock);
     if (!Terminate) {
         TCPSend("Done", Sock);
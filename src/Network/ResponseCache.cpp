@@ -0,0 +1,172 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Network/ResponseCache.h"
+#include <charconv>
+
+ResponseCache BackendCache;
+
+static const size_t MaxEntries = 256;
+
+// returns false if the response may not be stored, otherwise lowers Lifetime to max-age
+static bool ParseCacheControl(const std::string& Value, std::chrono::seconds& Lifetime) {
+    if (Value.find("no-store") != std::string::npos || Value.find("private") != std::string::npos)
+        return false;
+    if (Value.find("no-cache") != std::string::npos)
+        Lifetime = std::chrono::seconds(0);
+    auto pos = Value.find("max-age=");
+    if (pos != std::string::npos) {
+        long long MaxAge = 0;
+        auto Start = Value.data() + pos + 8;
+        if (std::from_chars(Start, Value.data() + Value.size(), MaxAge).ec == std::errc {} && std::chrono::seconds(MaxAge) < Lifetime)
+            Lifetime = std::chrono::seconds(MaxAge);
+    }
+    return true;
+}
+
+ResponseCache::Entry ResponseCache::Get(const std::string& Key, const Fetcher& Fetch) {
+    Ticket T;
+    if (auto Ready = Begin(Key, T))
+        return *Ready;
+    httplib::Result Res;
+    try {
+        Res = Fetch(T.Extra);
+    } catch (...) {
+        T.Promise.set_exception(std::current_exception());
+        std::scoped_lock Guard(Lock);
+        InFlight.erase(Key);
+        throw;
+    }
+    return Complete(T, Res);
+}
+
+std::optional<ResponseCache::Entry> ResponseCache::Begin(const std::string& Key, Ticket& T) {
+    T.Key = Key;
+    T.Now = std::chrono::steady_clock::now();
+    std::shared_future<Entry> Pending;
+    {
+        std::scoped_lock Guard(Lock);
+        T.Lifetime = TTL;
+        auto it = Entries.find(Key);
+        if (it != Entries.end()) {
+            if (it->second.Expires > T.Now) {
+                Hits++;
+                return it->second;
+            }
+            T.Cached = it->second;
+            T.Found = true;
+        }
+        // concurrent misses of one key share a single upstream request
+        auto Loading = InFlight.find(Key);
+        if (Loading != InFlight.end())
+            Pending = Loading->second;
+        else
+            InFlight[Key] = T.Promise.get_future().share();
+    }
+    if (Pending.valid()) {
+        Coalesced++;
+        return Pending.get();
+    }
+    if (T.Found && !T.Cached.ETag.empty())
+        T.Extra.emplace("If-None-Match", T.Cached.ETag);
+    return std::nullopt;
+}
+
+ResponseCache::Entry ResponseCache::Complete(Ticket& T, httplib::Result& Res) {
+    Entry Result;
+    try {
+        Result = Store(T, Res);
+    } catch (...) {
+        T.Promise.set_exception(std::current_exception());
+        std::scoped_lock Guard(Lock);
+        InFlight.erase(T.Key);
+        throw;
+    }
+    T.Promise.set_value(Result);
+    std::scoped_lock Guard(Lock);
+    InFlight.erase(T.Key);
+    return Result;
+}
+
+ResponseCache::Entry ResponseCache::Store(Ticket& T, httplib::Result& Res) {
+    auto& Cached = T.Cached;
+    auto& Lifetime = T.Lifetime;
+    if (!Res) {
+        // keep the UI working off the last good copy while the backend is unreachable
+        if (T.Found) {
+            Stale++;
+            return Cached;
+        }
+        Misses++;
+        Entry Failed;
+        Failed.Error = to_string(Res.error());
+        return Failed;
+    }
+
+    if (Res->status == 304 && T.Found) {
+        Revalidated++;
+        if (Res->has_header("Cache-Control"))
+            ParseCacheControl(Res->get_header_value("Cache-Control"), Lifetime);
+        Cached.Expires = T.Now + Lifetime;
+        std::scoped_lock Guard(Lock);
+        Entries[T.Key] = Cached;
+        return Cached;
+    }
+
+    Misses++;
+    Entry Fresh;
+    Fresh.Status = Res->status;
+    Fresh.Body = std::make_shared<const std::string>(std::move(Res->body));
+    Fresh.Generation = ++Generations;
+    Fresh.ContentType = Res->get_header_value("Content-Type");
+    Fresh.Encoding = Res->get_header_value("Content-Encoding");
+    Fresh.ETag = Res->get_header_value("ETag");
+    bool Storable = Res->status == 200 && Lifetime.count() > 0;
+    if (Storable && Res->has_header("Cache-Control"))
+        Storable = ParseCacheControl(Res->get_header_value("Cache-Control"), Lifetime);
+    Fresh.Expires = T.Now + Lifetime;
+    // entries that expire at once are still worth keeping if they can be revalidated
+    if (Storable && (Lifetime.count() > 0 || !Fresh.ETag.empty())) {
+        std::scoped_lock Guard(Lock);
+        if (Entries.size() >= MaxEntries && !Entries.contains(T.Key)) {
+            auto Oldest = Entries.begin();
+            for (auto it = Entries.begin(); it != Entries.end(); ++it) {
+                if (it->second.Expires < Oldest->second.Expires)
+                    Oldest = it;
+            }
+            Entries.erase(Oldest);
+        }
+        Entries[T.Key] = Fresh;
+    }
+    return Fresh;
+}
+
+void ResponseCache::SetTTL(std::chrono::seconds NewTTL) {
+    std::scoped_lock Guard(Lock);
+    TTL = NewTTL;
+    if (TTL.count() == 0)
+        Entries.clear();
+}
+
+bool ResponseCache::Enabled() {
+    std::scoped_lock Guard(Lock);
+    return TTL.count() > 0;
+}
+
+nlohmann::json ResponseCache::Stats() {
+    size_t Count;
+    {
+        std::scoped_lock Guard(Lock);
+        Count = Entries.size();
+    }
+    return {
+        { "entries", Count },
+        { "hits", Hits.load() },
+        { "misses", Misses.load() },
+        { "revalidated", Revalidated.load() },
+        { "stale", Stale.load() },
+        { "coalesced", Coalesced.load() },
+    };
+}
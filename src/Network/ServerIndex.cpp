@@ -0,0 +1,156 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Network/ServerIndex.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <nlohmann/json.hpp>
+#include <numeric>
+
+ServerIndex ServerList;
+
+// the backend sends most numbers and flags as strings
+static uint32_t ToUInt(const nlohmann::json& Value) {
+    if (Value.is_number_unsigned())
+        return Value.get<uint32_t>();
+    if (Value.is_string()) {
+        try {
+            return uint32_t(std::stoul(Value.get<std::string>()));
+        } catch (const std::exception&) { }
+    }
+    return 0;
+}
+
+static bool ToBool(const nlohmann::json& Value) {
+    if (Value.is_boolean())
+        return Value.get<bool>();
+    if (Value.is_string())
+        return Value.get<std::string>() == "true" || Value.get<std::string>() == "1";
+    return ToUInt(Value) != 0;
+}
+
+static std::string Field(const nlohmann::json& Server, const char* Key) {
+    auto it = Server.find(Key);
+    if (it == Server.end() || !it->is_string())
+        return "";
+    return it->get<std::string>();
+}
+
+// lower case without the ^x color and style codes server names are full of
+static std::string Plain(const std::string& Text) {
+    std::string Out;
+    Out.reserve(Text.size());
+    for (size_t i = 0; i < Text.size(); i++) {
+        if (Text[i] == '^' && i + 1 < Text.size()) {
+            i++;
+            continue;
+        }
+        Out += char(std::tolower(static_cast<unsigned char>(Text[i])));
+    }
+    return Out;
+}
+
+bool ServerIndex::IsCurrent(uint64_t Generation) {
+    std::scoped_lock Guard(Lock);
+    return Generation != 0 && Current->Generation == Generation;
+}
+
+void ServerIndex::Update(const std::string& Json, uint64_t Generation) {
+    auto d = nlohmann::json::parse(Json, nullptr, false);
+    if (d.is_discarded() || !d.is_array()) {
+        error("Server list is not a JSON array");
+        return;
+    }
+
+    auto Next = std::make_shared<Snapshot>();
+    Next->Generation = Generation;
+    Next->Servers.reserve(d.size());
+    for (const auto& Object : d) {
+        if (!Object.is_object())
+            continue;
+        Server S;
+        S.Raw = Object.dump();
+        S.Name = Plain(Field(Object, "sname"));
+        S.Map = Plain(Field(Object, "map"));
+        S.Version = Field(Object, "version");
+        S.Search = S.Name + '\n' + S.Map + '\n' + Plain(Field(Object, "sdesc")) + '\n' + Plain(Field(Object, "location"));
+        if (Object.contains("players"))
+            S.Players = ToUInt(Object["players"]);
+        if (Object.contains("maxplayers"))
+            S.MaxPlayers = ToUInt(Object["maxplayers"]);
+        if (Object.contains("official"))
+            S.Official = ToBool(Object["official"]);
+        if (Object.contains("password"))
+            S.Password = ToBool(Object["password"]);
+        Next->Servers.push_back(std::move(S));
+    }
+
+    // every order is ascending, descending queries walk it backwards
+    const auto& Servers = Next->Servers;
+    std::vector<uint32_t> Order(Servers.size());
+    std::iota(Order.begin(), Order.end(), 0);
+    Next->ByPlayers = Next->ByName = Next->ByMap = Order;
+    std::stable_sort(Next->ByPlayers.begin(), Next->ByPlayers.end(), [&](uint32_t a, uint32_t b) {
+        return Servers[a].Players < Servers[b].Players;
+    });
+    std::stable_sort(Next->ByName.begin(), Next->ByName.end(), [&](uint32_t a, uint32_t b) {
+        return Servers[a].Name < Servers[b].Name;
+    });
+    std::stable_sort(Next->ByMap.begin(), Next->ByMap.end(), [&](uint32_t a, uint32_t b) {
+        return Servers[a].Map < Servers[b].Map;
+    });
+
+    debug("Indexed " + std::to_string(Servers.size()) + " servers");
+    std::scoped_lock Guard(Lock);
+    Current = std::move(Next);
+}
+
+std::string ServerIndex::Find(const Query& Q) {
+    std::shared_ptr<const Snapshot> Snap;
+    {
+        std::scoped_lock Guard(Lock);
+        Snap = Current;
+    }
+    const std::vector<uint32_t>* Order = &Snap->ByPlayers;
+    if (Q.Sort == "name")
+        Order = &Snap->ByName;
+    else if (Q.Sort == "map")
+        Order = &Snap->ByMap;
+
+    std::string Text = Plain(Q.Text), Map = Plain(Q.Map);
+    auto Matches = [&](const Server& S) {
+        if (Q.OfficialOnly && !S.Official)
+            return false;
+        if (Q.HidePassword && S.Password)
+            return false;
+        if (Q.HideEmpty && S.Players == 0)
+            return false;
+        if (Q.HideFull && S.MaxPlayers != 0 && S.Players >= S.MaxPlayers)
+            return false;
+        if (!Map.empty() && S.Map.find(Map) == std::string::npos)
+            return false;
+        if (!Q.Version.empty() && S.Version != Q.Version)
+            return false;
+        return Text.empty() || S.Search.find(Text) != std::string::npos;
+    };
+
+    size_t Total = 0;
+    std::string Page = "[";
+    for (size_t i = 0; i < Order->size(); i++) {
+        uint32_t Id = (*Order)[Q.Descending ? Order->size() - 1 - i : i];
+        const Server& S = Snap->Servers[Id];
+        if (!Matches(S))
+            continue;
+        if (Total >= Q.Offset && Total - Q.Offset < Q.Limit) {
+            if (Page.size() > 1)
+                Page += ',';
+            Page += S.Raw;
+        }
+        Total++;
+    }
+    Page += ']';
+    return "{\"total\":" + std::to_string(Total) + ",\"offset\":" + std::to_string(Q.Offset) + ",\"servers\":" + Page + "}";
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Network/TieredCache.h"
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+TieredCache::TieredCache(fs::path Dir, size_t Capacity, std::chrono::seconds DiskTTL)
+    : Dir(std::move(Dir))
+    , Capacity(Capacity)
+    , DiskTTL(DiskTTL) { }
+
+static std::string FileName(const std::string& Key) {
+    std::stringstream ss;
+    ss << std::hex << std::hash<std::string> {}(Key);
+    return ss.str();
+}
+
+std::optional<TieredCache::Blob> TieredCache::ReadDisk(const std::string& Key) {
+    std::error_code ec;
+    auto Path = Dir / FileName(Key);
+    auto Written = fs::last_write_time(Path, ec);
+    if (ec || fs::file_time_type::clock::now() - Written > DiskTTL)
+        return std::nullopt;
+    std::ifstream File(Path, std::ios::binary);
+    if (!File.is_open())
+        return std::nullopt;
+    // the file starts with the key and the content type, one per line, then the raw data
+    std::string StoredKey;
+    Blob Value;
+    if (!std::getline(File, StoredKey) || StoredKey != Key || !std::getline(File, Value.Type))
+        return std::nullopt;
+    Value.Data.assign(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+    return Value;
+}
+
+void TieredCache::WriteDisk(const std::string& Key, const Blob& Value) {
+    std::error_code ec;
+    fs::create_directories(Dir, ec);
+    auto Path = Dir / FileName(Key);
+    auto Tmp = Path;
+    Tmp += ".tmp";
+    {
+        std::ofstream File(Tmp, std::ios::binary | std::ios::trunc);
+        if (!File.is_open())
+            return;
+        File << Key << '\n'
+             << Value.Type << '\n';
+        File.write(Value.Data.data(), std::streamsize(Value.Data.size()));
+    }
+    fs::rename(Tmp, Path, ec);
+}
+
+void TieredCache::Remember(const std::string& Key, const Blob& Value) {
+    auto it = Index.find(Key);
+    if (it != Index.end())
+        Recent.erase(it->second);
+    Recent.emplace_front(Key, Value);
+    Index[Key] = Recent.begin();
+    while (Recent.size() > Capacity) {
+        Index.erase(Recent.back().first);
+        Recent.pop_back();
+    }
+}
+
+std::optional<TieredCache::Blob> TieredCache::Get(const std::string& Key, const Loader& Load) {
+    std::promise<std::optional<Blob>> Promise;
+    std::shared_future<std::optional<Blob>> Pending;
+    {
+        std::scoped_lock Guard(Lock);
+        auto it = Index.find(Key);
+        if (it != Index.end()) {
+            Recent.splice(Recent.begin(), Recent, it->second);
+            return it->second->second;
+        }
+        auto Loading = InFlight.find(Key);
+        if (Loading != InFlight.end())
+            Pending = Loading->second;
+        else
+            InFlight[Key] = Promise.get_future().share();
+    }
+    if (Pending.valid())
+        return Pending.get();
+
+    auto Value = ReadDisk(Key);
+    if (!Value) {
+        try {
+            Value = Load();
+        } catch (const std::exception&) {
+            Value = std::nullopt;
+        }
+        if (Value)
+            WriteDisk(Key, *Value);
+    }
+
+    std::scoped_lock Guard(Lock);
+    if (Value)
+        Remember(Key, *Value);
+    Promise.set_value(Value);
+    InFlight.erase(Key);
+    return Value;
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Network/ZipVerifier.h"
+#include "Network/network.hpp"
+#include "zip_file.h"
+#include <cstring>
+
+bool ModCRCCheck = false;
+
+static size_t DiscardData(void*, mz_uint64, const void*, size_t n) {
+    return n;
+}
+
+bool VerifyZip(const std::string& Path, bool CheckCRC) {
+    mz_zip_archive Zip;
+    memset(&Zip, 0, sizeof(Zip));
+    if (!mz_zip_reader_init_file(&Zip, Path.c_str(), 0))
+        return false;
+    bool Valid = true;
+    if (CheckCRC) {
+        mz_uint Count = mz_zip_reader_get_num_files(&Zip);
+        for (mz_uint i = 0; i < Count && Valid && !Terminate; i++) {
+            // miniz compares the CRC of the inflated data with the central directory
+            if (!mz_zip_reader_extract_to_callback(&Zip, i, DiscardData, nullptr, 0))
+                Valid = false;
+        }
+    }
+    mz_zip_reader_end(&Zip);
+    return Valid;
+}
+
+ZipVerifier::ZipVerifier(size_t Workers) {
+    if (Workers == 0)
+        Workers = 1;
+    for (size_t i = 0; i < Workers; i++)
+        Threads.emplace_back(&ZipVerifier::Worker, this);
+}
+
+ZipVerifier::~ZipVerifier() {
+    {
+        std::scoped_lock Guard(Lock);
+        Stop = true;
+    }
+    Cv.notify_all();
+    for (auto& T : Threads)
+        T.join();
+}
+
+std::future<bool> ZipVerifier::Submit(const std::string& Path) {
+    std::packaged_task<bool()> Job([Path] { return VerifyZip(Path, ModCRCCheck); });
+    auto Result = Job.get_future();
+    {
+        std::scoped_lock Guard(Lock);
+        Jobs.emplace_back(std::move(Job));
+    }
+    Cv.notify_one();
+    return Result;
+}
+
+void ZipVerifier::Worker() {
+    while (true) {
+        std::packaged_task<bool()> Job;
+        {
+            std::unique_lock Guard(Lock);
+            Cv.wait(Guard, [this] { return Stop || !Jobs.empty(); });
+            if (Jobs.empty())
+                return;
+            Job = std::move(Jobs.front());
+            Jobs.pop_front();
+        }
+        Job();
+    }
+}
@@ -16,7 +16,10 @@
 #include <vector>
 #endif
 #include "Logger.h"
+#include "Trace.h"
 #include <fstream>
+#include <mutex>
+#include <nlohmann/json.hpp>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -27,6 +30,55 @@
 int TraceBack = 0;
 std::string GameDir;
 
+// what was found in Steam's library list and the game's integrity.json is kept in .game_env.json,
+// each value is only looked up again once the mtime of the file it came from changes
+static const std::filesystem::path EnvFile = ".game_env.json";
+static std::mutex EnvLock;
+static nlohmann::json Env = nlohmann::json::object();
+static bool EnvLoaded = false;
+
+static int64_t MTime(const std::string& Path) {
+    std::error_code ec;
+    auto Time = std::filesystem::last_write_time(Path, ec);
+    return ec ? -1 : int64_t(Time.time_since_epoch().count());
+}
+
+static void LoadEnv() {
+    if (EnvLoaded)
+        return;
+    EnvLoaded = true;
+    std::ifstream File(EnvFile);
+    if (!File.is_open())
+        return;
+    nlohmann::json d = nlohmann::json::parse(File, nullptr, false);
+    if (!d.is_discarded() && d.is_object())
+        Env = std::move(d);
+}
+
+static void SaveEnv() {
+    std::filesystem::path Tmp = EnvFile;
+    Tmp += ".tmp";
+    std::ofstream File(Tmp, std::ios::trunc);
+    if (!File.is_open())
+        return;
+    File << Env.dump();
+    File.close();
+    std::error_code ec;
+    std::filesystem::rename(Tmp, EnvFile, ec);
+}
+
+static bool EnvMatches(const char* Key, const std::string& Source, int64_t Time) {
+    return Env.contains(Key) && Env.value(std::string(Key) + "_source", "") == Source
+        && Env.value(std::string(Key) + "_mtime", int64_t(-2)) == Time;
+}
+
+static void StoreEnv(const char* Key, const std::string& Source, int64_t Time, const std::string& Value) {
+    Env[Key] = Value;
+    Env[std::string(Key) + "_source"] = Source;
+    Env[std::string(Key) + "_mtime"] = Time;
+    SaveEnv();
+}
+
 void lowExit(int code) {
     TraceBack = 0;
     std::string msg = "Failed to find the game please launch it. Report this if the issue persists code ";
@@ -290,6 +342,7 @@ bool IDCheck(std::string Man, std::string steam) {
     return a;
 }
 void LegitimacyCheck() {
+    TraceSpan Span("LegitimacyCheck");
 
 // std::string K1 = R"(Software\Valve\Steam)";
 // std::string K2 = R"(Software\Valve\Steam\Apps\284160)";
@@ -342,7 +395,16 @@ RegCloseKey(hKey);*/
     struct passwd* pw = getpwuid(getuid());
     std::string homeDir = pw->pw_dir;
     // Right now only steam is supported
-    std::ifstream libraryFolders(homeDir + "/.steam/root/steamapps/libraryfolders.vdf");
+    std::string Library = homeDir + "/.steam/root/steamapps/libraryfolders.vdf";
+    int64_t LibraryTime = MTime(Library);
+    std::scoped_lock Guard(EnvLock);
+    LoadEnv();
+    if (EnvMatches("game_dir", Library, LibraryTime) && std::filesystem::exists(Env["game_dir"].get<std::string>())) {
+        GameDir = Env["game_dir"].get<std::string>();
+        return;
+    }
+
+    std::ifstream libraryFolders(Library);
     auto root = tyti::vdf::read(libraryFolders);
 
     for (auto folderInfo : root.childs) {
@@ -351,6 +413,8 @@ RegCloseKey(hKey);*/
             break;
         }
     }
+    if (!GameDir.empty())
+        StoreEnv("game_dir", Library, LibraryTime, GameDir);
 #endif
 }
 std::string CheckVer(const std::string& dir) {
@@ -372,3 +436,19 @@ std::string CheckVer(const std::string& dir) {
     }
     return temp;
 }
+
+std::string GameVersion(const std::string& dir) {
+#if defined(_WIN32)
+    std::string Path = dir + "\\integrity.json";
+#elif defined(__linux__)
+    std::string Path = dir + "/integrity.json";
+#endif
+    int64_t Time = MTime(Path);
+    std::scoped_lock Guard(EnvLock);
+    LoadEnv();
+    if (EnvMatches("version", Path, Time))
+        return Env["version"].get<std::string>();
+    std::string Ver = CheckVer(dir);
+    StoreEnv("version", Path, Time, Ver);
+    return Ver;
+}
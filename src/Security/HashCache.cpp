@@ -0,0 +1,110 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Security/HashCache.h"
+#include "Logger.h"
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const fs::path CacheFile = ".hash_cache.json";
+
+static std::mutex Lock;
+static nlohmann::json Entries = nlohmann::json::object();
+static bool Loaded = false;
+static bool ForceVerify = false;
+
+// the inode, or the file index on Windows, changes when a file is replaced rather than rewritten
+static uint64_t FileId(const fs::path& Path) {
+#if defined(_WIN32)
+    HANDLE File = CreateFileW(Path.wstring().c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (File == INVALID_HANDLE_VALUE)
+        return 0;
+    BY_HANDLE_FILE_INFORMATION Info;
+    uint64_t Id = 0;
+    if (GetFileInformationByHandle(File, &Info))
+        Id = (uint64_t(Info.nFileIndexHigh) << 32) | Info.nFileIndexLow;
+    CloseHandle(File);
+    return Id;
+#elif defined(__linux__)
+    struct stat Info;
+    if (stat(Path.c_str(), &Info) != 0)
+        return 0;
+    return uint64_t(Info.st_ino);
+#else
+    return 0;
+#endif
+}
+
+static void Load() {
+    if (Loaded)
+        return;
+    Loaded = true;
+    std::ifstream File(CacheFile);
+    if (!File.is_open())
+        return;
+    nlohmann::json d = nlohmann::json::parse(File, nullptr, false);
+    if (!d.is_discarded() && d.is_object())
+        Entries = std::move(d);
+}
+
+static void Save() {
+    fs::path Tmp = CacheFile;
+    Tmp += ".tmp";
+    std::ofstream File(Tmp, std::ios::trunc);
+    if (!File.is_open())
+        return;
+    File << Entries.dump();
+    File.close();
+    std::error_code ec;
+    fs::rename(Tmp, CacheFile, ec);
+}
+
+void HashCache::SetForceVerify(bool Force) {
+    std::scoped_lock Guard(Lock);
+    ForceVerify = Force;
+}
+
+std::string HashCache::Get(const std::string& Path, const Hasher& Hash) {
+    std::error_code ec;
+    auto Absolute = fs::absolute(Path, ec);
+    auto Size = fs::file_size(Path, ec);
+    auto Written = fs::last_write_time(Path, ec);
+    // missing or unreadable files are hashed directly and never remembered
+    if (ec)
+        return Hash(Path);
+
+    nlohmann::json Key {
+        { "size", uint64_t(Size) },
+        { "mtime", int64_t(Written.time_since_epoch().count()) },
+        { "id", FileId(Absolute) },
+    };
+    std::string Name = Absolute.generic_string();
+    {
+        std::scoped_lock Guard(Lock);
+        Load();
+        if (!ForceVerify && Entries.contains(Name)) {
+            const auto& Entry = Entries[Name];
+            if (Entry.contains("hash") && Entry.contains("key") && Entry["key"] == Key) {
+                debug("Using remembered hash of " + Path);
+                return Entry["hash"].get<std::string>();
+            }
+        }
+    }
+
+    std::string Result = Hash(Path);
+    std::scoped_lock Guard(Lock);
+    Entries[Name] = { { "key", Key }, { "hash", Result } };
+    Save();
+    return Result;
+}
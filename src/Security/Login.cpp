@@ -8,6 +8,7 @@
 
 #include "Http.h"
 #include "Logger.h"
+#include "Trace.h"
 #include <filesystem>
 #include <fstream>
 #include <nlohmann/json.hpp>
@@ -100,6 +101,7 @@ std::string Login(const std::string& fields) {
 }
 
 void CheckLocalKey() {
+    TraceSpan Span("CheckLocalKey");
     if (fs::exists("key") && fs::file_size("key") < 100) {
         std::ifstream Key("key");
         if (Key.is_open()) {
@@ -0,0 +1,89 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Security/Sha256.h"
+#include "Trace.h"
+#include <fstream>
+#include <memory>
+#include <openssl/evp.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Sha256::Sha256()
+    : Ctx(EVP_MD_CTX_new()) {
+    EVP_DigestInit_ex(Ctx, EVP_sha256(), nullptr);
+}
+
+Sha256::~Sha256() {
+    EVP_MD_CTX_free(Ctx);
+}
+
+void Sha256::Update(const void* Data, size_t Len) {
+    EVP_DigestUpdate(Ctx, Data, Len);
+}
+
+Sha256::Digest Sha256::Final() {
+    Digest D {};
+    unsigned int Len = 0;
+    EVP_DigestFinal_ex(Ctx, D.data(), &Len);
+    return D;
+}
+
+// EVP picks the SHA-NI or ARMv8 crypto code path at runtime when the CPU has it
+std::string Sha256::File(const std::string& Path) {
+    TraceSpan Span("sha256", "hash", Path);
+    Sha256 Hash;
+#if defined(__linux__)
+    // mapping the file hashes straight out of the page cache without copying it
+    int Fd = open(Path.c_str(), O_RDONLY);
+    if (Fd < 0)
+        return "";
+    struct stat Info;
+    if (fstat(Fd, &Info) != 0 || !S_ISREG(Info.st_mode)) {
+        close(Fd);
+        return "";
+    }
+    if (Info.st_size > 0) {
+        void* Map = mmap(nullptr, size_t(Info.st_size), PROT_READ, MAP_PRIVATE, Fd, 0);
+        if (Map == MAP_FAILED) {
+            close(Fd);
+            return "";
+        }
+        madvise(Map, size_t(Info.st_size), MADV_SEQUENTIAL);
+        Hash.Update(Map, size_t(Info.st_size));
+        munmap(Map, size_t(Info.st_size));
+    }
+    close(Fd);
+#else
+    std::ifstream File(Path, std::ios::binary);
+    if (!File.is_open())
+        return "";
+    constexpr size_t ChunkSize = 4 * 1024 * 1024;
+    auto Buffer = std::make_unique<char[]>(ChunkSize);
+    while (File) {
+        File.read(Buffer.get(), ChunkSize);
+        if (File.gcount() > 0)
+            Hash.Update(Buffer.get(), size_t(File.gcount()));
+    }
+    if (File.bad())
+        return "";
+#endif
+    return Hex(Hash.Final());
+}
+
+std::string Sha256::Hex(const Digest& D) {
+    static const char* Chars = "0123456789abcdef";
+    std::string Ret;
+    Ret.reserve(D.size() * 2);
+    for (uint8_t b : D) {
+        Ret += Chars[b >> 4];
+        Ret += Chars[b & 0xF];
+    }
+    return Ret;
+}
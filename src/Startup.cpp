@@ -6,28 +6,34 @@
 /// Created by Anonymous275 on 7/16/2020
 ///
 
-#include "zip_file.h"
 #include <charconv>
 #include <httplib.h>
 #include <nlohmann/json.hpp>
+#include <rapidjson/reader.h>
 #include <string>
 #if defined(_WIN32)
 #include <windows.h>
 #elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 #endif
 #include "Http.h"
 #include "Logger.h"
 #include "Network/network.hpp"
+#include "Security/HashCache.h"
 #include "Security/Init.h"
+#include "Security/Sha256.h"
 #include "Startup.h"
-#include "hashpp.h"
+#include "Trace.h"
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <thread>
 
 extern int TraceBack;
 bool Dev = false;
+bool EarlyGameStart = false;
 int ProxyPort = 0;
 
 namespace fs = std::filesystem;
@@ -143,6 +149,7 @@ void URelaunch(int argc, char* args[]) {
 #endif
 
 void CheckName(int argc, char* args[]) {
+    TraceSpan Span("CheckName");
 #if defined(_WIN32)
     std::string DN = GetEN(), CDir = args[0], FN = CDir.substr(CDir.find_last_of('\\') + 1);
 #elif defined(__linux__)
@@ -158,19 +165,24 @@ void CheckName(int argc, char* args[]) {
     }
 }
 
-void CheckForUpdates(int argc, char* args[], const std::string& CV) {
-    std::string LatestHash = HTTP::Get("https://backend.beammp.com/sha/launcher?branch=" + Branch + "&pk=" + PublicKey);
-    std::string LatestVersion = HTTP::Get(
+// started next to the launcher update check and picked up by PreGame
+std::future<std::string> ModHashRequest;
+
+bool CheckForUpdates(const std::string& CV) {
+    TraceSpan Span("CheckForUpdates");
+    auto HashRequest = HTTP::GetAsync("https://backend.beammp.com/sha/launcher?branch=" + Branch + "&pk=" + PublicKey);
+    auto VersionRequest = HTTP::GetAsync(
         "https://backend.beammp.com/version/launcher?branch=" + Branch + "&pk=" + PublicKey);
+    if (!Dev)
+        ModHashRequest = HTTP::GetAsync("https://backend.beammp.com/sha/mod?branch=" + Branch + "&pk=" + PublicKey);
 
-    transform(LatestHash.begin(), LatestHash.end(), LatestHash.begin(), ::tolower);
     std::string EP(GetEP() + GetEN()), Back(GetEP() + "BeamMP-Launcher.back");
 
-    std::string FileHash = hashpp::get::getFileHash(hashpp::ALGORITHMS::SHA2_256, EP);
-#if defined(_WIN32)
-#elif defined(__linux__)
-    system("clear");
-#endif
+    std::string FileHash = HashCache::Get(EP, Sha256::File);
+
+    std::string LatestHash = HashRequest.get();
+    std::string LatestVersion = VersionRequest.get();
+    transform(LatestHash.begin(), LatestHash.end(), LatestHash.begin(), ::tolower);
 
     if (FileHash != LatestHash && IsOutdated(Version(VersionStrToInts(GetVer() + GetPatch())), Version(VersionStrToInts(LatestVersion))) && !Dev) {
         info("Launcher update found!");
@@ -185,11 +197,12 @@ void CheckForUpdates(int argc, char* args[], const std::string& CV) {
             "&pk="
                 + PublicKey + "&branch=" + Branch,
             EP);
-        URelaunch(argc, args);
+        return true;
 #endif
     } else
         info("Launcher version is up to date");
     TraceBack++;
+    return false;
 }
 
 void CustomPort(int argc, char* argv[]) {
@@ -242,20 +255,12 @@ void InitLauncher(int argc, char* argv[]) {
     InitLog();
     CheckName(argc, argv);
     LinuxPatch();
-    CheckLocalKey();
-    ConfigInit();
-    CustomPort(argc, argv);
-    CheckForUpdates(argc, argv, std::string(GetVer()) + GetPatch());
 }
 #elif defined(__linux__)
 void InitLauncher(int argc, char* argv[]) {
     system("clear");
     InitLog();
     CheckName(argc, argv);
-    CheckLocalKey();
-    ConfigInit();
-    CustomPort(argc, argv);
-    CheckForUpdates(argc, argv, std::string(GetVer()) + GetPatch());
 }
 #endif
 
@@ -263,23 +268,128 @@ size_t DirCount(const std::filesystem::path& path) {
     return (size_t)std::distance(std::filesystem::directory_iterator { path }, std::filesystem::directory_iterator {});
 }
 
+// deletes the trash folder on a low priority thread, whatever is left when the launcher exits goes next start
+static void PurgeTrash(const fs::path& Trash, size_t Moved, std::chrono::steady_clock::duration Spent) {
+    std::thread([Trash, Moved, Spent] {
+#if defined(_WIN32)
+        SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+        setpriority(PRIO_PROCESS, pid_t(syscall(SYS_gettid)), 19);
+#endif
+        auto Start = std::chrono::steady_clock::now();
+        std::error_code ec;
+        fs::remove_all(Trash, ec);
+        if (ec)
+            warn("Failed to empty " + Trash.string() + ": " + ec.message());
+        auto Ms = [](std::chrono::steady_clock::duration d) {
+            return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(d).count());
+        };
+        if (Moved > 0)
+            debug("Moved " + std::to_string(Moved) + " old mods out of the way in " + Ms(Spent) + "ms, deleting them took "
+                + Ms(std::chrono::steady_clock::now() - Start) + "ms in the background");
+    }).detach();
+}
+
 void CheckMP(const std::string& Path) {
     if (!fs::exists(Path))
         return;
-    size_t c = DirCount(fs::path(Path));
+    // next to the mods folder so the game never sees it, and on the same filesystem so a rename is enough
+    fs::path Trash = fs::path(Path).parent_path().parent_path() / "beammp_trash";
+    fs::path Bin = Trash / std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+    auto Start = std::chrono::steady_clock::now();
+    size_t Moved = 0;
     try {
         for (auto& p : fs::directory_iterator(Path)) {
             if (p.exists() && !p.is_directory()) {
                 std::string Name = p.path().filename().string();
                 for (char& Ch : Name)
                     Ch = char(tolower(Ch));
-                if (Name != "beammp.zip")
+                if (Name == "beammp.zip")
+                    continue;
+                std::error_code ec;
+                if (Moved == 0)
+                    fs::create_directories(Bin, ec);
+                fs::rename(p.path(), Bin / p.path().filename(), ec);
+                if (ec)
                     fs::remove(p.path());
+                Moved++;
             }
         }
     } catch (...) {
         fatal("We were unable to clean the multiplayer mods folder! Is the game still running or do you have something open in that folder?");
     }
+    if (fs::exists(Trash))
+        PurgeTrash(Trash, Moved, std::chrono::steady_clock::now() - Start);
+}
+
+// walks db.json without building a document and stops at mods.multiplayerbeammp.active
+struct ActiveFinder : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, ActiveFinder> {
+    explicit ActiveFinder(rapidjson::StringStream& Stream)
+        : Stream(Stream) { }
+
+    bool AtActive() const {
+        static const std::vector<std::string> Target { "", "mods", "multiplayerbeammp" };
+        return Path == Target && LastKey == "active";
+    }
+    bool Default() {
+        // a value that is not a bool is left to the full rewrite
+        Found = AtActive();
+        return !Found;
+    }
+    bool Bool(bool b) {
+        if (!AtActive())
+            return true;
+        Found = true;
+        IsBool = true;
+        Active = b;
+        End = Stream.Tell();
+        return false;
+    }
+    bool Key(const char* Str, rapidjson::SizeType Len, bool) {
+        LastKey.assign(Str, Len);
+        return true;
+    }
+    bool StartObject() {
+        Path.push_back(LastKey);
+        LastKey.clear();
+        if (Path.size() == 3 && Path[1] == "mods" && Path[2] == "multiplayerbeammp")
+            HasMod = true;
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) {
+        Path.pop_back();
+        return true;
+    }
+    bool StartArray() {
+        Path.push_back("[]");
+        return true;
+    }
+    bool EndArray(rapidjson::SizeType) {
+        Path.pop_back();
+        return true;
+    }
+
+    rapidjson::StringStream& Stream;
+    std::vector<std::string> Path;
+    std::string LastKey;
+    bool HasMod = false, Found = false, IsBool = false, Active = false;
+    size_t End = 0;
+};
+
+// the game may read db.json at any time, so it is replaced in one rename
+static void WriteDb(const std::string& File, const std::string& Data) {
+    std::string Tmp = File + ".tmp";
+    std::ofstream ofs(Tmp, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+        error("Failed to write " + File);
+        return;
+    }
+    ofs << Data;
+    ofs.close();
+    std::error_code ec;
+    fs::rename(Tmp, File, ec);
+    if (ec)
+        error("Failed to write " + File + ": " + ec.message());
 }
 
 void EnableMP() {
@@ -289,42 +399,51 @@ void EnableMP() {
     auto Size = fs::file_size(File);
     if (Size < 2)
         return;
-    std::ifstream db(File);
-    if (db.is_open()) {
-        std::string Data(Size, 0);
-        db.read(&Data[0], Size);
-        db.close();
-        nlohmann::json d = nlohmann::json::parse(Data, nullptr, false);
-        if (Data.at(0) != '{' || d.is_discarded()) {
-            // error("Failed to parse " + File); //TODO illegal formatting
-            return;
-        }
-        if (d.contains("mods") && d["mods"].contains("multiplayerbeammp")) {
-            d["mods"]["multiplayerbeammp"]["active"] = true;
-            std::ofstream ofs(File);
-            if (ofs.is_open()) {
-                ofs << d.dump();
-                ofs.close();
-            } else {
-                error("Failed to write " + File);
-            }
-        }
+    std::ifstream db(File, std::ios::binary);
+    if (!db.is_open())
+        return;
+    std::string Data(Size, 0);
+    db.read(&Data[0], Size);
+    Data.resize(size_t(db.gcount()));
+    db.close();
+    if (Data.empty() || Data.at(0) != '{')
+        return;
+
+    rapidjson::StringStream Stream(Data.c_str());
+    ActiveFinder Finder(Stream);
+    rapidjson::Reader Reader;
+    Reader.Parse(Stream, Finder);
+    if (Finder.Found && Finder.Active)
+        return;
+    if (Finder.IsBool && Finder.End >= 5) {
+        // swap the false that ends at End, the rest of the file stays byte for byte the same
+        Data.replace(Finder.End - 5, 5, "true");
+        WriteDb(File, Data);
+        return;
     }
+    if (Reader.HasParseError() && Reader.GetParseErrorCode() != rapidjson::kParseErrorTermination) {
+        // error("Failed to parse " + File); //TODO illegal formatting
+        return;
+    }
+    if (!Finder.HasMod)
+        return;
+
+    // active is missing or not a bool, only then is the whole document rebuilt
+    nlohmann::json d = nlohmann::json::parse(Data, nullptr, false);
+    if (d.is_discarded())
+        return;
+    d["mods"]["multiplayerbeammp"]["active"] = true;
+    WriteDb(File, d.dump());
 }
 
 void PreGame(const std::string& GamePath) {
-    std::string GameVer = CheckVer(GamePath);
+    TraceSpan Span("PreGame");
+    std::string GameVer = GameVersion(GamePath);
     info("Game Version : " + GameVer);
 
     CheckMP(GetGamePath() + "mods/multiplayer");
 
     if (!Dev) {
-        std::string LatestHash = HTTP::Get("https://backend.beammp.com/sha/mod?branch=" + Branch + "&pk=" + PublicKey);
-        transform(LatestHash.begin(), LatestHash.end(), LatestHash.begin(), ::tolower);
-        LatestHash.erase(std::remove_if(LatestHash.begin(), LatestHash.end(),
-                             [](auto const& c) -> bool { return !std::isalnum(c); }),
-            LatestHash.end());
-
         try {
             if (!fs::exists(GetGamePath() + "mods/multiplayer")) {
                 fs::create_directories(GetGamePath() + "mods/multiplayer");
@@ -333,6 +452,27 @@ void PreGame(const std::string& GamePath) {
         } catch (std::exception& e) {
             fatal(e.what());
         }
+
+        std::string Target(GetGamePath() + "mods/unpacked/beammp");
+
+        if (fs::is_directory(Target)) {
+            fs::remove_all(Target);
+        }
+    }
+}
+
+// the part of the game preparation that only touches BeamMP.zip, it may overlap with the game's boot
+void UpdateMP() {
+    TraceSpan Span("UpdateMP");
+    if (!Dev) {
+        std::string LatestHash = ModHashRequest.valid()
+            ? ModHashRequest.get()
+            : HTTP::Get("https://backend.beammp.com/sha/mod?branch=" + Branch + "&pk=" + PublicKey);
+        transform(LatestHash.begin(), LatestHash.end(), LatestHash.begin(), ::tolower);
+        LatestHash.erase(std::remove_if(LatestHash.begin(), LatestHash.end(),
+                             [](auto const& c) -> bool { return !std::isalnum(c); }),
+            LatestHash.end());
+
 #if defined(_WIN32)
         std::string ZipPath(GetGamePath() + R"(mods\multiplayer\BeamMP.zip)");
 #elif defined(__linux__)
@@ -340,20 +480,16 @@ void PreGame(const std::string& GamePath) {
         std::string ZipPath(GetGamePath() + R"(mods/multiplayer/beammp.zip)");
 #endif
 
-        std::string FileHash = hashpp::get::getFileHash(hashpp::ALGORITHMS::SHA2_256, ZipPath);
+        std::string FileHash = HashCache::Get(ZipPath, Sha256::File);
 
         if (FileHash != LatestHash) {
             info("Downloading BeamMP Update " + LatestHash);
-            HTTP::Download("https://backend.beammp.com/builds/client?download=true"
-                           "&pk="
-                    + PublicKey + "&branch=" + Branch,
-                ZipPath);
-        }
-
-        std::string Target(GetGamePath() + "mods/unpacked/beammp");
-
-        if (fs::is_directory(Target)) {
-            fs::remove_all(Target);
+            // an early started game may hold the old zip open on Windows, running it anyway would mean joining with the old mod
+            if (!HTTP::Download("https://backend.beammp.com/builds/client?download=true"
+                                "&pk="
+                        + PublicKey + "&branch=" + Branch,
+                    ZipPath))
+                fatal("Failed to update the BeamMP mod, close the game and start the launcher again");
         }
     }
 }
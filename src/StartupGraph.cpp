@@ -0,0 +1,72 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "StartupGraph.h"
+#include "Logger.h"
+#include <stdexcept>
+
+static long long Ms(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
+void StartupGraph::Add(const std::string& Name, const std::vector<std::string>& After, std::function<void()> Step) {
+    std::vector<std::shared_future<void>> Deps;
+    for (const auto& Dep : After) {
+        auto it = Index.find(Dep);
+        if (it == Index.end())
+            throw std::logic_error("startup step '" + Name + "' depends on unknown step '" + Dep + "'");
+        Deps.push_back(Tasks[it->second].Done);
+    }
+    Index[Name] = Tasks.size();
+    Task& Self = Tasks.emplace_back();
+    Self.Name = Name;
+    Self.After = After;
+    Self.Done = std::async(std::launch::async, [this, &Self, Deps = std::move(Deps), Step = std::move(Step)] {
+        for (const auto& Dep : Deps)
+            Dep.get();
+        Self.Start = std::chrono::steady_clock::now() - Begin;
+        Step();
+        Self.End = std::chrono::steady_clock::now() - Begin;
+    }).share();
+}
+
+void StartupGraph::Run() {
+    std::exception_ptr Failure;
+    for (auto& T : Tasks) {
+        try {
+            T.Done.get();
+        } catch (...) {
+            if (!Failure)
+                Failure = std::current_exception();
+        }
+    }
+    if (Failure)
+        std::rethrow_exception(Failure);
+    LogCriticalPath();
+}
+
+// walks back from the step that finished last, always through the dependency that finished last
+void StartupGraph::LogCriticalPath() {
+    if (Tasks.empty())
+        return;
+    const Task* Last = &Tasks.front();
+    for (const auto& T : Tasks) {
+        if (T.End > Last->End)
+            Last = &T;
+    }
+    std::string Path;
+    for (const Task* T = Last; T != nullptr;) {
+        std::string Step = T->Name + " " + std::to_string(Ms(T->End - T->Start)) + "ms";
+        Path = Path.empty() ? Step : Step + " -> " + Path;
+        const Task* Blocker = nullptr;
+        for (const auto& Dep : T->After) {
+            const Task& D = Tasks[Index[Dep]];
+            if (Blocker == nullptr || D.End > Blocker->End)
+                Blocker = &D;
+        }
+        T = Blocker;
+    }
+    info("Startup took " + std::to_string(Ms(Last->End)) + "ms, critical path: " + Path);
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2019-present Anonymous275.
+// BeamMP Launcher code is not in the public domain and is not free software.
+// One must be granted explicit permission by the copyright holder in order to modify or distribute any part of the source or binaries.
+// Anything else is prohibited. Modified works may not be published and have be upstreamed to the official repository.
+
+#include "Trace.h"
+#include "Logger.h"
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <thread>
+#include <vector>
+
+struct TraceEvent {
+    std::string Name, Category, Detail;
+    int64_t Start, Duration;
+    int Thread;
+};
+
+// the trace is kept for the whole run, later events are dropped once it is full
+static constexpr size_t MaxEvents = 4096;
+
+static const auto Epoch = std::chrono::steady_clock::now();
+static std::mutex Lock;
+static std::vector<TraceEvent> Events;
+static std::map<std::thread::id, int> Threads;
+static std::string File;
+
+static int64_t Micros(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t - Epoch).count();
+}
+
+TraceSpan::TraceSpan(std::string Name, std::string Category, std::string Detail)
+    : Name(std::move(Name))
+    , Category(std::move(Category))
+    , Detail(std::move(Detail))
+    , Start(std::chrono::steady_clock::now()) { }
+
+TraceSpan::~TraceSpan() {
+    auto End = std::chrono::steady_clock::now();
+    std::scoped_lock Guard(Lock);
+    if (Events.size() >= MaxEvents)
+        return;
+    // small stable thread numbers read better in the viewer than hashed ids
+    auto [it, New] = Threads.try_emplace(std::this_thread::get_id(), int(Threads.size()) + 1);
+    Events.push_back({ std::move(Name), std::move(Category), std::move(Detail), Micros(Start), Micros(End) - Micros(Start), it->second });
+}
+
+std::string Trace::Json() {
+    nlohmann::json List = nlohmann::json::array();
+    {
+        std::scoped_lock Guard(Lock);
+        for (const auto& e : Events) {
+            nlohmann::json Event {
+                { "name", e.Name },
+                { "cat", e.Category },
+                { "ph", "X" },
+                { "ts", e.Start },
+                { "dur", e.Duration },
+                { "pid", 1 },
+                { "tid", e.Thread },
+            };
+            if (!e.Detail.empty())
+                Event["args"] = { { "detail", e.Detail } };
+            List.push_back(std::move(Event));
+        }
+    }
+    nlohmann::json Root { { "traceEvents", std::move(List) }, { "displayTimeUnit", "ms" } };
+    return Root.dump();
+}
+
+void Trace::SetFile(const std::string& Path) {
+    std::scoped_lock Guard(Lock);
+    File = Path;
+}
+
+void Trace::Save() {
+    std::string Path;
+    {
+        std::scoped_lock Guard(Lock);
+        Path = File;
+    }
+    if (Path.empty())
+        return;
+    std::ofstream Out(Path, std::ios::trunc);
+    if (!Out.is_open()) {
+        error("Failed to write trace to " + Path);
+        return;
+    }
+    Out << Json();
+    info("Startup trace written to " + Path);
+}
@@ -7,11 +7,15 @@
 ///
 #include "Http.h"
 #include "Logger.h"
+#include "Network/ModCache.h"
 #include "Network/network.hpp"
 #include "Security/Init.h"
 #include "Startup.h"
+#include "StartupGraph.h"
+#include "Trace.h"
 #include <iostream>
 #include <thread>
+#include <vector>
 
 [[noreturn]] void flush() {
     while (true) {
@@ -30,16 +34,58 @@ int main(int argc, char* argv[]) {
 
     InitLauncher(argc, argv);
 
-    try {
-        LegitimacyCheck();
-    } catch (std::exception& e) {
-        fatal("Main 1 : " + std::string(e.what()));
-    }
+    // the core binds DEFAULT_PORT, so the config and then the command line port are read first
+    ConfigInit();
+    CustomPort(argc, argv);
 
+    // a game that is already running can connect right away, both listeners hold its
+    // requests until SetLauncherReady. CheckName above may relaunch, so not any earlier
+    std::thread Core(CoreNetwork);
     HTTP::StartProxy();
-    PreGame(GetGameDir());
-    InitGame(GetGameDir());
-    CoreNetwork();
+
+    // game discovery does not need the login
+    StartupGraph Startup;
+    Startup.Add("key", {}, CheckLocalKey);
+    Startup.Add("game", {}, [] {
+        try {
+            LegitimacyCheck();
+        } catch (std::exception& e) {
+            fatal("Main 1 : " + std::string(e.what()));
+        }
+    });
+    // a downloaded launcher update relaunches once every step is done, never from inside one
+    bool Relaunch = false;
+    Startup.Add("updates", { "key" }, [&] {
+        Relaunch = CheckForUpdates(std::string(GetVer()) + GetPatch());
+    });
+    Startup.Add("cache", {}, ModCache::StartCollector);
+    Startup.Add("pregame", { "game" }, [] { PreGame(GetGameDir()); });
+    Startup.Add("modupdate", { "pregame", "updates" }, [&] {
+        if (!Relaunch)
+            UpdateMP();
+    });
+    // the game reads mods/multiplayer and db.json while booting, so it always waits for the cleanup,
+    // and for the launcher update so a relaunch never starts a second game.
+    // The early start only overlaps the BeamMP.zip check and download, the core still holds everything
+    // but status polls until Run is done, so the game can not join anything before that is done
+    std::vector<std::string> GameAfter = { "pregame", "updates" };
+    if (!EarlyGameStart)
+        GameAfter.push_back("modupdate");
+    Startup.Add("initgame", GameAfter, [&] {
+        // the relaunched launcher starts the game
+        if (Relaunch)
+            return;
+        if (EarlyGameStart)
+            info("Starting the game while the BeamMP mod is updated");
+        InitGame(GetGameDir());
+    });
+    Startup.Run();
+    Trace::Save();
+    if (Relaunch)
+        URelaunch(argc, argv);
+
+    SetLauncherReady();
+    Core.join();
 
     /// TODO: make sure to use argv[0] for everything that should be in the same dir (mod down ect...)
 }